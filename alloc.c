@@ -0,0 +1,226 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "alloc.h"
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+#ifndef MAP_HUGE_SHIFT
+# define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+# define MAP_HUGE_2MB   (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+# define MAP_HUGE_1GB   (30 << MAP_HUGE_SHIFT)
+#endif
+#define HAVE_HUGETLB
+#endif
+
+/*
+ * The allocated buffers are remembered, because the aligned and the mmapped
+ * ones can't be released by a plain free(). The allocations are rare, so
+ * a simple list protected by a spinlock is good enough (the threads of the
+ * multi-threaded tests allocate their buffers simultaneously).
+ */
+typedef struct allocation
+{
+    void              *ptr;
+    void              *base;    /* the pointer to be freed or unmapped */
+    int64_t            size;    /* the mapped size, or 0 for malloc */
+    struct allocation *next;
+} allocation;
+
+static allocation  *allocations;
+static volatile int allocations_lock;
+
+static void lock(void)
+{
+    while (__sync_lock_test_and_set(&allocations_lock, 1)) {}
+}
+
+static void unlock(void)
+{
+    __sync_lock_release(&allocations_lock);
+}
+
+static void *alloc_aligned(int64_t size, int mode, void **base)
+{
+    char *ptr;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    void *aligned;
+    if (mode != PAGES_DEFAULT)
+    {
+        /* The huge page size is not known here, 4 MiB is enough in practice */
+        if (posix_memalign(&aligned, 4 * 1024 * 1024, size) != 0)
+            return NULL;
+        if (madvise(aligned, size, mode == PAGES_THP ?
+                                   MADV_HUGEPAGE : MADV_NOHUGEPAGE) != 0)
+        {
+            free(aligned);
+            return NULL;
+        }
+        *base = aligned;
+        return aligned;
+    }
+#else
+    if (mode != PAGES_DEFAULT)
+        return NULL;
+#endif
+    /* The default pages come from the plain malloc without any hints */
+    if (!(ptr = (char *)malloc(size + 4095)))
+        return NULL;
+    *base = ptr;
+    return (void *)(((uintptr_t)ptr + 4095) & ~(uintptr_t)4095);
+}
+
+static void *alloc_hugetlb(int64_t *size, int mode)
+{
+#ifdef HAVE_HUGETLB
+    int64_t pagesize = mode == PAGES_1G ? 1024 * 1024 * 1024 : 2 * 1024 * 1024;
+    void *ptr;
+
+    *size = (*size + pagesize - 1) & ~(pagesize - 1);
+    ptr = mmap(NULL, *size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+               (mode == PAGES_1G ? MAP_HUGE_1GB : MAP_HUGE_2MB), -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+#else
+    return NULL;
+#endif
+}
+
+void *alloc_pages(int64_t size, int mode)
+{
+    allocation *a = (allocation *)malloc(sizeof(allocation));
+
+    if (!a || size <= 0)
+    {
+        free(a);
+        return NULL;
+    }
+    if (mode == PAGES_2M || mode == PAGES_1G)
+    {
+        a->size = size;
+        a->ptr = a->base = alloc_hugetlb(&a->size, mode);
+    }
+    else
+    {
+        a->size = 0;
+        a->ptr = alloc_aligned(size, mode, &a->base);
+    }
+    if (!a->ptr)
+    {
+        free(a);
+        return NULL;
+    }
+
+    lock();
+    a->next = allocations;
+    allocations = a;
+    unlock();
+    return a->ptr;
+}
+
+void free_pages(void *ptr)
+{
+    allocation **p, *a = NULL;
+
+    if (!ptr)
+        return;
+    lock();
+    for (p = &allocations; *p; p = &(*p)->next)
+    {
+        if ((*p)->ptr == ptr)
+        {
+            a = *p;
+            *p = a->next;
+            break;
+        }
+    }
+    unlock();
+    if (!a)
+        return;
+#ifdef HAVE_HUGETLB
+    if (a->size)
+        munmap(a->base, a->size);
+    else
+#endif
+        free(a->base);
+    free(a);
+}
+
+static struct
+{
+    int         mode;
+    const char *option;
+    const char *name;
+    const char *description;
+} page_modes[] =
+{
+    { PAGES_4K,      "4k",      "madv_nohugepage", "MADV_NOHUGEPAGE" },
+    { PAGES_DEFAULT, "default", "default",         "default" },
+    { PAGES_THP,     "thp",     "madv_hugepage",   "MADV_HUGEPAGE" },
+    { PAGES_2M,      "2m",      "hugetlb_2m",      "MAP_HUGETLB 2 MiB" },
+    { PAGES_1G,      "1g",      "hugetlb_1g",      "MAP_HUGETLB 1 GiB" },
+    { 0, NULL, NULL, NULL }
+};
+
+int parse_page_mode(const char *name, int *mode)
+{
+    int i;
+    for (i = 0; page_modes[i].option; i++)
+    {
+        if (strcmp(name, page_modes[i].option) == 0)
+        {
+            *mode = page_modes[i].mode;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const char *page_mode_name(int mode)
+{
+    int i;
+    for (i = 0; page_modes[i].option; i++)
+        if (page_modes[i].mode == mode)
+            return page_modes[i].name;
+    return "default";
+}
+
+const char *page_mode_description(int mode)
+{
+    int i;
+    for (i = 0; page_modes[i].option; i++)
+        if (page_modes[i].mode == mode)
+            return page_modes[i].description;
+    return "default";
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __ALLOC_H__
+#define __ALLOC_H__
+
+#include <stdint.h>
+
+/*
+ * The kind of pages backing the memory buffers. The values are compatible
+ * with the huge pages convention used by the latency tests (positive: huge
+ * pages, negative: no huge pages, zero: the system default).
+ */
+enum
+{
+    PAGES_4K      = -1,     /* MADV_NOHUGEPAGE */
+    PAGES_DEFAULT = 0,      /* whatever the system gives */
+    PAGES_THP     = 1,      /* transparent huge pages (MADV_HUGEPAGE) */
+    PAGES_2M      = 2,      /* explicit 2 MiB pages (MAP_HUGETLB) */
+    PAGES_1G      = 3       /* explicit 1 GiB pages (MAP_HUGETLB) */
+};
+
+/*
+ * Allocate 'size' bytes backed by the given kind of pages. The buffer is
+ * aligned at least to 4 KiB (to the huge page size with MAP_HUGETLB) and
+ * must be released by free_pages(). Returns NULL on failure, for example
+ * if the huge pages are not supported or not reserved in hugetlbfs
+ * (see /sys/kernel/mm/hugepages).
+ */
+void *alloc_pages(int64_t size, int mode);
+
+/* Release the buffer allocated by alloc_pages() (NULL is ignored) */
+void free_pages(void *ptr);
+
+/* Parse the mode name (4k, default, thp, 2m or 1g). Returns 0 on error */
+int parse_page_mode(const char *name, int *mode);
+
+/* Short name of the mode for the structured report, like "hugetlb_2m" */
+const char *page_mode_name(int mode);
+
+/* Human-readable description of the mode, like "MAP_HUGETLB 2 MiB" */
+const char *page_mode_description(int mode);
+
+#endif
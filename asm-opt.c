@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <stdint.h>
 #include "asm-opt.h"
 
 #if defined(__linux__) || defined(ANDROID) || defined(__ANDROID__)
@@ -120,16 +121,26 @@ int check_cpu_feature(const char *feature)
 #endif
 
 static bench_info empty[] = { { NULL, 0, NULL } };
+static stream_info stream_empty[] = { { NULL, 0, NULL } };
 
 #if defined(__i386__) || defined(__amd64__)
 
 #include "x86-sse2.h"
+#include "x86-avx.h"
 
 static bench_info x86_sse2[] =
 {
+    { "SSE2 read", 0, aligned_block_read_sse2 },
+    { "SSE2 read prefetched (32 bytes step)", 0, aligned_block_read_pf32_sse2 },
+    { "SSE2 read prefetched (64 bytes step)", 0, aligned_block_read_pf64_sse2 },
+    { "SSE2 read 2 data streams", 0, aligned_block_read2_sse2 },
+    { "SSE2 read 2 data streams prefetched (64 bytes step)", 0, aligned_block_read2_pf64_sse2 },
+    { "SSE2 read 4 data streams", 0, aligned_block_read4_sse2 },
+    { "SSE2 read 4 data streams prefetched (64 bytes step)", 0, aligned_block_read4_pf64_sse2 },
     { "MOVSB copy", 0, aligned_block_copy_movsb },
     { "MOVSD copy", 0, aligned_block_copy_movsd },
     { "SSE2 copy", 0, aligned_block_copy_sse2 },
+    { "SSE2 unaligned copy", 0, unaligned_block_copy_sse2 },
     { "SSE2 nontemporal copy", 0, aligned_block_copy_nt_sse2 },
     { "SSE2 copy prefetched (32 bytes step)", 0, aligned_block_copy_pf32_sse2 },
     { "SSE2 copy prefetched (64 bytes step)", 0, aligned_block_copy_pf64_sse2 },
@@ -141,11 +152,16 @@ static bench_info x86_sse2[] =
     { "SSE2 2-pass nontemporal copy", 1, aligned_block_copy_nt_sse2 },
     { "SSE2 fill", 0, aligned_block_fill_sse2 },
     { "SSE2 nontemporal fill", 0, aligned_block_fill_nt_sse2 },
+    { "SSE2 read:write 3:1", 0, aligned_block_rw31_sse2 },
+    { "SSE2 read:write 2:1", 0, aligned_block_rw21_sse2 },
+    { "SSE2 read:write 1:1", 0, aligned_block_rw11_sse2 },
+    { "SSE2 read:write 1:2", 0, aligned_block_rw12_sse2 },
     { NULL, 0, NULL }
 };
 
 static bench_info x86_sse2_fb[] =
 {
+    { "SSE2 read (from framebuffer)", 0, aligned_block_read_sse2 },
     { "MOVSD copy (from framebuffer)", 0, aligned_block_copy_movsd },
     { "MOVSD 2-pass copy (from framebuffer)", 1, aligned_block_copy_movsd },
     { "SSE2 copy (from framebuffer)", 0, aligned_block_copy_sse2 },
@@ -186,20 +202,230 @@ static int check_sse2_support(void)
 #endif
 }
 
+static bench_info x86_avx[] =
+{
+    { "AVX read", 0, aligned_block_read_avx },
+    { "AVX read prefetched (64 bytes step)", 0, aligned_block_read_pf64_avx },
+    { "AVX read 2 data streams", 0, aligned_block_read2_avx },
+    { "AVX read 4 data streams", 0, aligned_block_read4_avx },
+    { "AVX copy", 0, aligned_block_copy_avx },
+    { "AVX unaligned copy", 0, unaligned_block_copy_avx },
+    { "AVX nontemporal copy", 0, aligned_block_copy_nt_avx },
+    { "AVX copy prefetched (32 bytes step)", 0, aligned_block_copy_pf32_avx },
+    { "AVX copy prefetched (64 bytes step)", 0, aligned_block_copy_pf64_avx },
+    { "AVX nontemporal copy prefetched (32 bytes step)", 0, aligned_block_copy_nt_pf32_avx },
+    { "AVX nontemporal copy prefetched (64 bytes step)", 0, aligned_block_copy_nt_pf64_avx },
+    { "AVX 2-pass copy", 1, aligned_block_copy_avx },
+    { "AVX 2-pass copy prefetched (32 bytes step)", 1, aligned_block_copy_pf32_avx },
+    { "AVX 2-pass copy prefetched (64 bytes step)", 1, aligned_block_copy_pf64_avx },
+    { "AVX 2-pass nontemporal copy", 1, aligned_block_copy_nt_avx },
+    { "AVX fill", 0, aligned_block_fill_avx },
+    { "AVX nontemporal fill", 0, aligned_block_fill_nt_avx },
+    { "AVX read:write 3:1", 0, aligned_block_rw31_avx },
+    { "AVX read:write 2:1", 0, aligned_block_rw21_avx },
+    { "AVX read:write 1:1", 0, aligned_block_rw11_avx },
+    { "AVX read:write 1:2", 0, aligned_block_rw12_avx },
+    { NULL, 0, NULL }
+};
+
+static bench_info x86_avx2[] =
+{
+    { "AVX2 nontemporal load copy", 0, aligned_block_copy_ntload_avx2 },
+    { "AVX2 nontemporal load/store copy", 0, aligned_block_copy_ntload_nt_avx2 },
+    { NULL, 0, NULL }
+};
+
+static bench_info x86_avx512[] =
+{
+    { "AVX-512 read", 0, aligned_block_read_avx512 },
+    { "AVX-512 copy", 0, aligned_block_copy_avx512 },
+    { "AVX-512 nontemporal copy", 0, aligned_block_copy_nt_avx512 },
+    { "AVX-512 copy prefetched (64 bytes step)", 0, aligned_block_copy_pf64_avx512 },
+    { "AVX-512 nontemporal copy prefetched (64 bytes step)", 0, aligned_block_copy_nt_pf64_avx512 },
+    { "AVX-512 2-pass copy", 1, aligned_block_copy_avx512 },
+    { "AVX-512 2-pass copy prefetched (64 bytes step)", 1, aligned_block_copy_pf64_avx512 },
+    { "AVX-512 2-pass nontemporal copy", 1, aligned_block_copy_nt_avx512 },
+    { "AVX-512 fill", 0, aligned_block_fill_avx512 },
+    { "AVX-512 nontemporal fill", 0, aligned_block_fill_nt_avx512 },
+    { NULL, 0, NULL }
+};
+
+static bench_info x86_avx_fb[] =
+{
+    { "AVX read (from framebuffer)", 0, aligned_block_read_avx },
+    { "AVX copy (from framebuffer)", 0, aligned_block_copy_avx },
+    { "AVX 2-pass copy (from framebuffer)", 1, aligned_block_copy_avx },
+    { NULL, 0, NULL }
+};
+
+static bench_info x86_avx2_fb[] =
+{
+    { "AVX2 nontemporal load copy (from framebuffer)", 0, aligned_block_copy_ntload_avx2 },
+    { "AVX2 nontemporal load 2-pass copy (from framebuffer)", 1, aligned_block_copy_ntload_avx2 },
+    { NULL, 0, NULL }
+};
+
+static stream_info x86_sse2_stream[] =
+{
+    { "SSE2 STREAM copy", STREAM_COPY, stream_copy_sse2 },
+    { "SSE2 STREAM scale", STREAM_SCALE, stream_scale_sse2 },
+    { "SSE2 STREAM add", STREAM_ADD, stream_add_sse2 },
+    { "SSE2 STREAM triad", STREAM_TRIAD, stream_triad_sse2 },
+    { "SSE2 nontemporal STREAM copy", STREAM_COPY, stream_copy_nt_sse2 },
+    { "SSE2 nontemporal STREAM scale", STREAM_SCALE, stream_scale_nt_sse2 },
+    { "SSE2 nontemporal STREAM add", STREAM_ADD, stream_add_nt_sse2 },
+    { "SSE2 nontemporal STREAM triad", STREAM_TRIAD, stream_triad_nt_sse2 },
+    { NULL, 0, NULL }
+};
+
+static stream_info x86_avx_stream[] =
+{
+    { "AVX STREAM copy", STREAM_COPY, stream_copy_avx },
+    { "AVX STREAM scale", STREAM_SCALE, stream_scale_avx },
+    { "AVX STREAM add", STREAM_ADD, stream_add_avx },
+    { "AVX STREAM triad", STREAM_TRIAD, stream_triad_avx },
+    { "AVX nontemporal STREAM copy", STREAM_COPY, stream_copy_nt_avx },
+    { "AVX nontemporal STREAM scale", STREAM_SCALE, stream_scale_nt_avx },
+    { "AVX nontemporal STREAM add", STREAM_ADD, stream_add_nt_avx },
+    { "AVX nontemporal STREAM triad", STREAM_TRIAD, stream_triad_nt_avx },
+    { NULL, 0, NULL }
+};
+
+#define TABLE_SIZE(table) (sizeof(table) / sizeof(table[0]))
+
+static bench_info x86_all[TABLE_SIZE(x86_sse2) + TABLE_SIZE(x86_avx) +
+                          TABLE_SIZE(x86_avx2) + TABLE_SIZE(x86_avx512)];
+
+static bench_info x86_all_fb[TABLE_SIZE(x86_sse2_fb) + TABLE_SIZE(x86_avx_fb) +
+                             TABLE_SIZE(x86_avx2_fb)];
+
+static stream_info x86_all_stream[TABLE_SIZE(x86_sse2_stream) +
+                                  TABLE_SIZE(x86_avx_stream)];
+
+static void x86_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t *eax,
+                      uint32_t *ebx, uint32_t *ecx, uint32_t *edx)
+{
+#if defined(__i386__) && defined(__PIC__)
+    /* EBX is used as the GOT pointer and can't be clobbered */
+    __asm__ volatile (
+        "xchgl    %%ebx,     %1\n"
+        "cpuid\n"
+        "xchgl    %%ebx,     %1\n"
+        : "=a" (*eax), "=&r" (*ebx), "=c" (*ecx), "=d" (*edx)
+        : "0" (leaf), "2" (subleaf));
+#else
+    __asm__ volatile (
+        "cpuid\n"
+        : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+        : "0" (leaf), "2" (subleaf));
+#endif
+}
+
+#define X86_FEATURE_AVX     1
+#define X86_FEATURE_AVX2    2
+#define X86_FEATURE_AVX512  4
+
+/*
+ * Check both the CPU support (CPUID) and the OS support (the OS must save
+ * and restore the wide registers on context switches, which is reported
+ * by XGETBV) for AVX, AVX2 and AVX-512F.
+ */
+static int check_avx_support(void)
+{
+    uint32_t eax, ebx, ecx, edx, xcr0_lo, xcr0_hi;
+    uint32_t max_leaf;
+    int features = 0;
+
+    /* CPUID itself may be missing on very old 32-bit processors */
+    if (!check_sse2_support())
+        return 0;
+
+    x86_cpuid(0, 0, &max_leaf, &ebx, &ecx, &edx);
+    if (max_leaf < 1)
+        return 0;
+    x86_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    /* OSXSAVE (bit 27) and AVX (bit 28) */
+    if ((ecx & (3 << 27)) != (3 << 27))
+        return 0;
+
+    __asm__ volatile ("xgetbv\n" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+    /* XMM and YMM state */
+    if ((xcr0_lo & 0x06) != 0x06)
+        return 0;
+    features |= X86_FEATURE_AVX;
+
+    if (max_leaf < 7)
+        return features;
+    x86_cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+    if (ebx & (1 << 5))
+        features |= X86_FEATURE_AVX2;
+    /* AVX-512F also needs the opmask and ZMM state */
+    if ((ebx & (1 << 16)) && (xcr0_lo & 0xE6) == 0xE6)
+        features |= X86_FEATURE_AVX512;
+    return features;
+}
+
+static bench_info *append_benchmarks(bench_info *dst, bench_info *src)
+{
+    while (src->f)
+        *dst++ = *src++;
+    *dst = *src;
+    return dst;
+}
+
 bench_info *get_asm_benchmarks(void)
 {
-    if (check_sse2_support())
-        return x86_sse2;
-    else
+    int features;
+    bench_info *bi;
+
+    if (!check_sse2_support())
         return empty;
+
+    features = check_avx_support();
+    bi = append_benchmarks(x86_all, x86_sse2);
+    if (features & X86_FEATURE_AVX)
+        bi = append_benchmarks(bi, x86_avx);
+    if (features & X86_FEATURE_AVX2)
+        bi = append_benchmarks(bi, x86_avx2);
+    if (features & X86_FEATURE_AVX512)
+        bi = append_benchmarks(bi, x86_avx512);
+    return x86_all;
 }
 
 bench_info *get_asm_framebuffer_benchmarks(void)
 {
-    if (check_sse2_support())
-        return x86_sse2_fb;
-    else
+    int features;
+    bench_info *bi;
+
+    if (!check_sse2_support())
         return empty;
+
+    features = check_avx_support();
+    bi = append_benchmarks(x86_all_fb, x86_sse2_fb);
+    if (features & X86_FEATURE_AVX)
+        bi = append_benchmarks(bi, x86_avx_fb);
+    if (features & X86_FEATURE_AVX2)
+        bi = append_benchmarks(bi, x86_avx2_fb);
+    return x86_all_fb;
+}
+
+stream_info *get_asm_stream_benchmarks(void)
+{
+    stream_info *si = x86_all_stream;
+    int i;
+
+    if (!check_sse2_support())
+        return stream_empty;
+
+    for (i = 0; x86_sse2_stream[i].f; i++)
+        *si++ = x86_sse2_stream[i];
+    if (check_avx_support() & X86_FEATURE_AVX)
+    {
+        for (i = 0; x86_avx_stream[i].f; i++)
+            *si++ = x86_avx_stream[i];
+    }
+    *si = stream_empty[0];
+    return x86_all_stream;
 }
 
 #elif defined(__arm__)
@@ -425,3 +651,12 @@ bench_info *get_asm_framebuffer_benchmarks(void)
 }
 
 #endif
+
+#if !defined(__i386__) && !defined(__amd64__)
+
+stream_info *get_asm_stream_benchmarks(void)
+{
+    return stream_empty;
+}
+
+#endif
@@ -33,7 +33,30 @@ typedef struct
     void (*f)(int64_t *, int64_t *, int);
 } bench_info;
 
+/*
+ * STREAM kernels compute 'dst' = 'src1' (copy), STREAM_SCALAR * 'src1'
+ * (scale), 'src1' + 'src2' (add) or 'src1' + STREAM_SCALAR * 'src2' (triad)
+ * for the arrays of 'size' bytes.
+ */
+enum
+{
+    STREAM_COPY,
+    STREAM_SCALE,
+    STREAM_ADD,
+    STREAM_TRIAD
+};
+
+#define STREAM_SCALAR 3.0
+
+typedef struct
+{
+    const char *description;
+    int op;
+    void (*f)(double *, double *, double *, int);
+} stream_info;
+
 bench_info *get_asm_benchmarks(void);
 bench_info *get_asm_framebuffer_benchmarks(void);
+stream_info *get_asm_stream_benchmarks(void);
 
 #endif
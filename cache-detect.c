@@ -0,0 +1,149 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cache-detect.h"
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static double median(const double *y, int n)
+{
+    double *tmp = (double *)malloc(n * sizeof(double));
+    double result;
+    if (!tmp)
+        return y[0];
+    memcpy(tmp, y, n * sizeof(double));
+    qsort(tmp, n, sizeof(double), compare_doubles);
+    result = (n % 2) ? tmp[n / 2] : (tmp[n / 2 - 1] + tmp[n / 2]) / 2;
+    free(tmp);
+    return result;
+}
+
+int find_curve_steps(const double *y, int npoints, double rel_tolerance,
+                     double abs_tolerance, int minpoints,
+                     curve_step *steps, int maxsteps)
+{
+    int i = 0, j, nsteps = 0;
+
+    while (i < npoints && nsteps < maxsteps)
+    {
+        j = i;
+        while (j + 1 < npoints &&
+               y[j + 1] <= y[j] * (1 + rel_tolerance) + abs_tolerance &&
+               y[j + 1] <= y[i] * (1 + 2 * rel_tolerance) + abs_tolerance)
+        {
+            j++;
+        }
+
+        if (j - i + 1 >= minpoints || j == npoints - 1)
+        {
+            steps[nsteps].first = i;
+            steps[nsteps].last = j;
+            steps[nsteps].level = median(y + i, j - i + 1);
+            nsteps++;
+        }
+        i = j + 1;
+    }
+    return nsteps;
+}
+
+#ifdef __linux__
+
+static int read_sysfs_string(const char *path, char *buffer, int bufsize)
+{
+    FILE *f = fopen(path, "r");
+    char *p;
+    if (!f)
+        return 0;
+    if (!fgets(buffer, bufsize, f))
+    {
+        fclose(f);
+        return 0;
+    }
+    fclose(f);
+    if ((p = strchr(buffer, '\n')))
+        *p = 0;
+    return 1;
+}
+
+static int compare_cache_levels(const void *a, const void *b)
+{
+    return ((const sysfs_cache_info *)a)->level -
+           ((const sysfs_cache_info *)b)->level;
+}
+
+int read_sysfs_caches(int cpu, sysfs_cache_info *caches, int maxcaches)
+{
+    char path[256], buffer[64], *end;
+    int index, ncaches = 0;
+    int64_t size;
+
+    for (index = 0; ncaches < maxcaches; index++)
+    {
+        sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/type",
+                cpu, index);
+        if (!read_sysfs_string(path, buffer, sizeof(buffer)))
+            break;
+        if (strcmp(buffer, "Instruction") == 0)
+            continue;
+        strncpy(caches[ncaches].type, buffer, sizeof(caches[ncaches].type));
+        caches[ncaches].type[sizeof(caches[ncaches].type) - 1] = 0;
+
+        sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/level",
+                cpu, index);
+        if (!read_sysfs_string(path, buffer, sizeof(buffer)))
+            continue;
+        caches[ncaches].level = atoi(buffer);
+
+        sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%d/size",
+                cpu, index);
+        if (!read_sysfs_string(path, buffer, sizeof(buffer)))
+            continue;
+        size = strtol(buffer, &end, 10);
+        if (*end == 'K')
+            size *= 1024;
+        else if (*end == 'M')
+            size *= 1024 * 1024;
+        caches[ncaches].size = size;
+        ncaches++;
+    }
+
+    qsort(caches, ncaches, sizeof(sysfs_cache_info), compare_cache_levels);
+    return ncaches;
+}
+
+#else
+
+int read_sysfs_caches(int cpu, sysfs_cache_info *caches, int maxcaches)
+{
+    return 0;
+}
+
+#endif
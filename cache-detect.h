@@ -0,0 +1,64 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CACHE_DETECT_H__
+#define __CACHE_DETECT_H__
+
+#include <stdint.h>
+
+/* A flat part of a latency curve */
+typedef struct
+{
+    int    first;   /* index of the first point */
+    int    last;    /* index of the last point */
+    double level;   /* median value of the points */
+} curve_step;
+
+/*
+ * Split the curve (a sequence of values for increasing block sizes) into
+ * flat steps separated by transitions. A point belongs to the current step
+ * if it doesn't exceed the previous point and the first point of the step
+ * by more than the relative tolerance (plus the absolute tolerance for
+ * the values close to zero). Steps shorter than 'minpoints' are discarded
+ * as noise or parts of a gradual transition, except for the last one.
+ * Returns the number of steps.
+ */
+int find_curve_steps(const double *y, int npoints, double rel_tolerance,
+                     double abs_tolerance, int minpoints,
+                     curve_step *steps, int maxsteps);
+
+typedef struct
+{
+    int     level;
+    char    type[16];
+    int64_t size;
+} sysfs_cache_info;
+
+/*
+ * Read the data/unified cache information for the given CPU from
+ * /sys/devices/system/cpu/cpuN/cache. The result is sorted by the cache
+ * level. Returns the number of caches (0 if the information is missing).
+ */
+int read_sysfs_caches(int cpu, sysfs_cache_info *caches, int maxcaches);
+
+#endif
@@ -37,7 +37,15 @@
 #endif
 
 #include "util.h"
+#include "alloc.h"
 #include "asm-opt.h"
+#include "threads.h"
+#include "numa.h"
+#include "cache-detect.h"
+#include "report.h"
+#include "timer.h"
+#include "perf.h"
+#include "plugin.h"
 #include "version.h"
 
 #define SIZE             (32 * 1024 * 1024)
@@ -49,6 +57,70 @@
 # define LATBENCH_COUNT  10000000
 #endif
 
+/*
+ * Try both MADV_NOHUGEPAGE and MADV_HUGEPAGE for the latency tests (and use
+ * the default pages for the other buffers). This is not a valid page mode.
+ */
+#define HUGEPAGE_AUTO    100
+
+/*
+ * Runtime configuration. The defaults come from the macros above and can
+ * be changed from the command line.
+ */
+static struct
+{
+    int         bufsize;        /* buffer size for the bandwidth tests */
+    int         blocksize;      /* temporary buffer size for 2-pass copy */
+    int         maxrepeats;     /* the largest number of measurements */
+    double      sample_time;    /* duration of one bandwidth measurement */
+    double      time_budget;    /* time limit for one test (0 = no limit) */
+    int         latbench_size;  /* buffer size for the latency tests */
+    int         latbench_count; /* number of accesses per measurement */
+    int         hugepage;       /* page mode (see alloc.h) or HUGEPAGE_AUTO */
+    const char *kernels;        /* comma separated list of glob patterns */
+} cfg =
+{
+    SIZE, BLOCKSIZE, MAXREPEATS, 0.5, 0, SIZE * 2, LATBENCH_COUNT,
+    HUGEPAGE_AUTO, NULL
+};
+
+/* Check if the time budget for the test started at 't_start' is used up */
+static int out_of_time(double t_start)
+{
+    return cfg.time_budget > 0 && gettime() - t_start >= cfg.time_budget;
+}
+
+/* The page mode for the buffers of the bandwidth tests */
+static int buffer_page_mode(void)
+{
+    return cfg.hugepage == HUGEPAGE_AUTO ? PAGES_DEFAULT : cfg.hugepage;
+}
+
+/* Check if the benchmark is selected by the --kernels option */
+static int kernel_selected(const char *description)
+{
+    char pattern[256];
+    const char *p = cfg.kernels, *end;
+
+    if (!p)
+        return 1;
+    while (*p)
+    {
+        end = strchr(p, ',');
+        if (!end)
+            end = p + strlen(p);
+        if (end - p < (int)sizeof(pattern))
+        {
+            memcpy(pattern, p, end - p);
+            pattern[end - p] = 0;
+            if (glob_match(pattern, description))
+                return 1;
+        }
+        p = *end ? end + 1 : end;
+    }
+    return 0;
+}
+
 #ifdef __linux__
 static void *mmap_framebuffer(size_t *fbsize)
 {
@@ -76,27 +148,54 @@ static void *mmap_framebuffer(size_t *fbsize)
 }
 #endif
 
-static double bandwidth_bench_helper(int64_t *dstbuf, int64_t *srcbuf,
-                                     int64_t *tmpbuf,
-                                     int size, int blocksize,
-                                     const char *indent_prefix,
-                                     int use_tmpbuf,
-                                     void (*f)(int64_t *, int64_t *, int),
-                                     const char *description)
+static const char *format_size(char *buffer, int64_t size)
+{
+    if (size >= 1024 * 1024 && size % (1024 * 1024) == 0)
+        sprintf(buffer, "%d MiB", (int)(size / (1024 * 1024)));
+    else if (size >= 1024 * 1024)
+        sprintf(buffer, "%.2f MiB", size / (1024. * 1024.));
+    else if (size >= 1024 && size % 1024 == 0)
+        sprintf(buffer, "%d KiB", (int)(size / 1024));
+    else
+        sprintf(buffer, "%d B", (int)size);
+    return buffer;
+}
+
+/* The largest block size, which can be passed to the benchmark functions */
+#define BANDWIDTH_MAX_CHUNK (1 << 30)
+
+/*
+ * Measure the bandwidth of the function 'f' and return the best result (in
+ * MB/s). The summary of all the measurements is returned via 'm'. The buffers
+ * larger than BANDWIDTH_MAX_CHUNK are processed in multiple calls.
+ */
+static double bandwidth_measure(int64_t *dstbuf, int64_t *srcbuf,
+                                int64_t *tmpbuf,
+                                int64_t size, int blocksize,
+                                int use_tmpbuf,
+                                void (*f)(int64_t *, int64_t *, int),
+                                measurement *m)
 {
-    int i, j, loopcount, innerloopcount, n;
+    int i, loopcount, innerloopcount, n;
+    int64_t j;
     double t1, t2;
     double speed, maxspeed;
-    double s, s0, s1, s2;
+    double s, s0, s1, s2, t_start;
+    double samples[MAX_SAMPLES];
 
-    /* do up to MAXREPEATS measurements */
+    /* do up to cfg.maxrepeats measurements */
     s = s0 = s1 = s2 = 0;
     maxspeed   = 0;
-    for (n = 0; n < MAXREPEATS; n++)
+    perf_reset();
+    t_start = gettime();
+    for (n = 0; n < cfg.maxrepeats; n++)
     {
-        f(dstbuf, srcbuf, size);
+        for (j = 0; j < size; j += BANDWIDTH_MAX_CHUNK)
+            f(dstbuf + j / sizeof(int64_t), srcbuf + j / sizeof(int64_t),
+              size - j < BANDWIDTH_MAX_CHUNK ? size - j : BANDWIDTH_MAX_CHUNK);
         loopcount = 0;
         innerloopcount = 1;
+        perf_start();
         t1 = gettime();
         do
         {
@@ -112,6 +211,19 @@ static double bandwidth_bench_helper(int64_t *dstbuf, int64_t *srcbuf,
                     }
                 }
             }
+            else if (size > BANDWIDTH_MAX_CHUNK)
+            {
+                for (i = 0; i < innerloopcount; i++)
+                {
+                    for (j = 0; j < size; j += BANDWIDTH_MAX_CHUNK)
+                    {
+                        int chunk = size - j < BANDWIDTH_MAX_CHUNK ?
+                                    size - j : BANDWIDTH_MAX_CHUNK;
+                        f(dstbuf + j / sizeof(int64_t),
+                          srcbuf + j / sizeof(int64_t), chunk);
+                    }
+                }
+            }
             else
             {
                 for (i = 0; i < innerloopcount; i++)
@@ -121,8 +233,10 @@ static double bandwidth_bench_helper(int64_t *dstbuf, int64_t *srcbuf,
             }
             innerloopcount *= 2;
             t2 = gettime();
-        } while (t2 - t1 < 0.5);
+        } while (t2 - t1 < cfg.sample_time);
+        perf_stop((double)size * loopcount);
         speed = (double)size * loopcount / (t2 - t1) / 1000000.;
+        samples[n] = speed;
 
         s0 += 1;
         s1 += speed;
@@ -137,8 +251,31 @@ static double bandwidth_bench_helper(int64_t *dstbuf, int64_t *srcbuf,
             if (s < maxspeed / 1000.)
                 break;
         }
+        if (out_of_time(t_start))
+            break;
     }
 
+    measurement_from_samples(m, samples, s0, 1);
+    return maxspeed;
+}
+
+static double bandwidth_bench_helper(int64_t *dstbuf, int64_t *srcbuf,
+                                     int64_t *tmpbuf,
+                                     int size, int blocksize,
+                                     const char *indent_prefix,
+                                     int use_tmpbuf,
+                                     void (*f)(int64_t *, int64_t *, int),
+                                     const char *description,
+                                     const char *test)
+{
+    double s, maxspeed;
+    measurement m;
+
+    maxspeed = bandwidth_measure(dstbuf, srcbuf, tmpbuf, size, blocksize,
+                                 use_tmpbuf, f, &m);
+    s = m.stddev;
+    report_add(test, description, size, 1, &m, "MB/s", buffer_page_mode());
+
     if (maxspeed > 0 && s / maxspeed * 100. >= 0.1)
     {
         printf("%s%-52s : %8.1f MB/s (%.1f%%)\n", indent_prefix, description,
@@ -148,6 +285,8 @@ static double bandwidth_bench_helper(int64_t *dstbuf, int64_t *srcbuf,
     {
         printf("%s%-52s : %8.1f MB/s\n", indent_prefix, description, maxspeed);
     }
+    perf_print("     ", "B");
+    perf_report(test, description, size, "B", buffer_page_mode());
     return maxspeed;
 }
 
@@ -163,6 +302,15 @@ void memset_wrapper(int64_t *dst, int64_t *src, int size)
 
 static bench_info c_benchmarks[] =
 {
+    { "C read", 0, aligned_block_read },
+    { "C read prefetched (32 bytes step)", 0, aligned_block_read_pf32 },
+    { "C read prefetched (64 bytes step)", 0, aligned_block_read_pf64 },
+    { "C read 2 data streams", 0, aligned_block_read2 },
+    { "C read 2 data streams prefetched (32 bytes step)", 0, aligned_block_read2_pf32 },
+    { "C read 2 data streams prefetched (64 bytes step)", 0, aligned_block_read2_pf64 },
+    { "C read 4 data streams", 0, aligned_block_read4 },
+    { "C read 4 data streams prefetched (32 bytes step)", 0, aligned_block_read4_pf32 },
+    { "C read 4 data streams prefetched (64 bytes step)", 0, aligned_block_read4_pf64 },
     { "C copy backwards", 0, aligned_block_copy_backwards },
     { "C copy backwards (32 byte blocks)", 0, aligned_block_copy_backwards_bs32 },
     { "C copy backwards (64 byte blocks)", 0, aligned_block_copy_backwards_bs64 },
@@ -176,6 +324,10 @@ static bench_info c_benchmarks[] =
     { "C fill (shuffle within 16 byte blocks)", 0, aligned_block_fill_shuffle16 },
     { "C fill (shuffle within 32 byte blocks)", 0, aligned_block_fill_shuffle32 },
     { "C fill (shuffle within 64 byte blocks)", 0, aligned_block_fill_shuffle64 },
+    { "C read:write 3:1", 0, aligned_block_rw31 },
+    { "C read:write 2:1", 0, aligned_block_rw21 },
+    { "C read:write 1:1", 0, aligned_block_rw11 },
+    { "C read:write 1:2", 0, aligned_block_rw12 },
     { NULL, 0, NULL }
 };
 
@@ -188,18 +340,634 @@ static bench_info libc_benchmarks[] =
 
 void bandwidth_bench(int64_t *dstbuf, int64_t *srcbuf, int64_t *tmpbuf,
                      int size, int blocksize, const char *indent_prefix,
-                     bench_info *bi)
+                     bench_info *bi, const char *test)
+{
+    while (bi->f)
+    {
+        if (kernel_selected(bi->description))
+            bandwidth_bench_helper(dstbuf, srcbuf, tmpbuf, size, blocksize,
+                                   indent_prefix, bi->use_tmpbuf,
+                                   bi->f,
+                                   bi->description, test);
+        bi++;
+    }
+}
+
+#define SWEEP_MIN_SIZE      (4 * 1024)
+#define SWEEP_MAX_KERNELS   256
+
+static const char *sweep_default_kernels[] =
+{
+    "C read",
+    "standard memcpy",
+    "standard memset",
+    NULL
+};
+
+static int sweep_kernel_selected(const char *description)
+{
+    int i;
+    if (cfg.kernels)
+        return kernel_selected(description);
+    if (plugin_benchmark(description))
+        return 1;
+    for (i = 0; sweep_default_kernels[i]; i++)
+        if (strcmp(description, sweep_default_kernels[i]) == 0)
+            return 1;
+    return 0;
+}
+
+static int sweep_add_kernels(bench_info **kernels, int nkernels,
+                             bench_info *bi)
+{
+    while (bi->f && nkernels < SWEEP_MAX_KERNELS)
+    {
+        if (sweep_kernel_selected(bi->description))
+            kernels[nkernels++] = bi;
+        bi++;
+    }
+    return nkernels;
+}
+
+/*
+ * Run the benchmarks selected by --kernels (or the default set) on the
+ * working sets from 4 KiB up to 'maxsize' bytes, with 2 steps per each
+ * doubling of the size.
+ */
+static void bandwidth_sweep(int64_t maxsize)
+{
+    bench_info *kernels[SWEEP_MAX_KERNELS];
+    int64_t *srcbuf, *dstbuf, *tmpbuf;
+    int64_t size, testsize;
+    void *poolbuf;
+    char buf[32];
+    double s, maxspeed;
+    measurement m;
+    int i, k, nkernels = 0;
+
+    nkernels = sweep_add_kernels(kernels, nkernels, c_benchmarks);
+    nkernels = sweep_add_kernels(kernels, nkernels, libc_benchmarks);
+    nkernels = sweep_add_kernels(kernels, nkernels, get_asm_benchmarks());
+    nkernels = sweep_add_kernels(kernels, nkernels, get_plugin_benchmarks());
+    if (nkernels == 0)
+    {
+        printf("\n No benchmarks match '%s'.\n", cfg.kernels);
+        return;
+    }
+
+    poolbuf = alloc_four_nonaliased_buffers((void **)&srcbuf, maxsize,
+                                            (void **)&dstbuf, maxsize,
+                                            (void **)&tmpbuf, cfg.blocksize,
+                                            NULL, 0,
+                                            buffer_page_mode());
+    if (!poolbuf)
+    {
+        printf("\n Failed to allocate the buffers (2 x %s).\n",
+               format_size(buf, maxsize));
+        return;
+    }
+
+    for (i = 0; i < nkernels; i++)
+    {
+        printf("\n %s:\n", kernels[i]->description);
+        for (size = SWEEP_MIN_SIZE; size <= maxsize; size *= 2)
+        {
+            for (k = 0; k < 2; k++)
+            {
+                testsize = size + size * k / 2;
+                if (testsize > maxsize)
+                    break;
+                maxspeed = bandwidth_measure(dstbuf, srcbuf, tmpbuf,
+                                             testsize, cfg.blocksize,
+                                             kernels[i]->use_tmpbuf,
+                                             kernels[i]->f, &m);
+                s = m.stddev;
+                report_add("bandwidth sweep", kernels[i]->description,
+                           testsize, 1, &m, "MB/s", buffer_page_mode());
+                printf(" %10s : %8.1f MB/s", format_size(buf, testsize),
+                       maxspeed);
+                if (maxspeed > 0 && s / maxspeed * 100. >= 0.1)
+                    printf(" (%.1f%%)", s / maxspeed * 100.);
+                printf("\n");
+                perf_print("              ", "B");
+                perf_report("bandwidth sweep", kernels[i]->description,
+                            testsize, "B", buffer_page_mode());
+                fflush(stdout);
+            }
+        }
+    }
+
+    free_pages(poolbuf);
+}
+
+typedef struct
+{
+    void          (*f)(int64_t *, int64_t *, int);
+    int             use_tmpbuf;
+    int             size;
+    int             blocksize;
+    int             nthreads;
+    int             mem_node;
+    spin_barrier_t  barrier;
+    volatile int    stop;
+    volatile int    done;
+    volatile int    alloc_failed;
+    double         *speed;
+    double         *best_speed;
+    double          maxspeed;
+    double          s0, s1, s2;
+    double          t_start;
+    double          samples[MAX_SAMPLES];
+} mt_bandwidth_ctx;
+
+/*
+ * Each thread allocates its own buffers (so that they get placed in the
+ * memory local to the CPU on NUMA systems), then all the threads start
+ * running the benchmarked function simultaneously. The first thread
+ * is responsible for stopping the others and for collecting statistics.
+ */
+static void mt_bandwidth_thread(int thread_index, int cpu, void *arg)
+{
+    mt_bandwidth_ctx *ctx = (mt_bandwidth_ctx *)arg;
+    int64_t *srcbuf, *dstbuf, *tmpbuf;
+    void *poolbuf;
+    int i, j, n, loopcount;
+    double t1, t2, speed, s;
+
+    if (ctx->mem_node >= 0)
+        numa_bind_memory(ctx->mem_node);
+
+    poolbuf = alloc_four_nonaliased_buffers((void **)&srcbuf, ctx->size,
+                                            (void **)&dstbuf, ctx->size,
+                                            (void **)&tmpbuf, ctx->blocksize,
+                                            NULL, 0,
+                                            buffer_page_mode());
+    /* All the threads give up if any of them could not get the buffers */
+    if (!poolbuf)
+        ctx->alloc_failed = 1;
+    spin_barrier_wait(&ctx->barrier);
+    if (ctx->alloc_failed)
+    {
+        free_pages(poolbuf);
+        return;
+    }
+
+    for (n = 0; n < cfg.maxrepeats; n++)
+    {
+        ctx->f(dstbuf, srcbuf, ctx->size);
+        spin_barrier_wait(&ctx->barrier);
+
+        loopcount = 0;
+        t1 = gettime();
+        do
+        {
+            if (ctx->use_tmpbuf)
+            {
+                for (j = 0; j < ctx->size; j += ctx->blocksize)
+                {
+                    ctx->f(tmpbuf, srcbuf + j / sizeof(int64_t), ctx->blocksize);
+                    ctx->f(dstbuf + j / sizeof(int64_t), tmpbuf, ctx->blocksize);
+                }
+            }
+            else
+            {
+                ctx->f(dstbuf, srcbuf, ctx->size);
+            }
+            loopcount++;
+            if (thread_index == 0 && gettime() - t1 >= cfg.sample_time)
+                ctx->stop = 1;
+        } while (!ctx->stop);
+        t2 = gettime();
+        ctx->speed[thread_index] =
+                (double)ctx->size * loopcount / (t2 - t1) / 1000000.;
+
+        spin_barrier_wait(&ctx->barrier);
+        if (thread_index == 0)
+        {
+            speed = 0;
+            for (i = 0; i < ctx->nthreads; i++)
+                speed += ctx->speed[i];
+
+            ctx->samples[n] = speed;
+            ctx->s0 += 1;
+            ctx->s1 += speed;
+            ctx->s2 += speed * speed;
+
+            if (speed > ctx->maxspeed)
+            {
+                ctx->maxspeed = speed;
+                memcpy(ctx->best_speed, ctx->speed,
+                       ctx->nthreads * sizeof(double));
+            }
+
+            if (ctx->s0 > 2)
+            {
+                s = sqrt((ctx->s0 * ctx->s2 - ctx->s1 * ctx->s1) /
+                         (ctx->s0 * (ctx->s0 - 1)));
+                if (s < ctx->maxspeed / 1000.)
+                    ctx->done = 1;
+            }
+            if (out_of_time(ctx->t_start))
+                ctx->done = 1;
+            ctx->stop = 0;
+        }
+        spin_barrier_wait(&ctx->barrier);
+        if (ctx->done)
+            break;
+    }
+
+    free_pages(poolbuf);
+}
+
+/*
+ * Run 'f' on 'nthreads' threads simultaneously and return the best aggregate
+ * bandwidth, -1 if the threads could not be started or -2 if the buffers
+ * could not be allocated in the selected huge pages mode. If 'mem_node' is
+ * not negative, then all the buffers are allocated in that NUMA node. The
+ * bandwidth of the slowest and the fastest thread is returned via 'minspeed'
+ * and 'maxspeed', the summary of the aggregate bandwidth measurements via 'm'.
+ */
+static double mt_bandwidth_measure(int nthreads, const int *cpus, int ncpus,
+                                   int mem_node, int size, int blocksize,
+                                   int use_tmpbuf,
+                                   void (*f)(int64_t *, int64_t *, int),
+                                   double *minspeed, double *maxspeed,
+                                   measurement *m)
+{
+    mt_bandwidth_ctx ctx;
+    int i;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.f = f;
+    ctx.use_tmpbuf = use_tmpbuf;
+    ctx.size = size;
+    ctx.blocksize = blocksize;
+    ctx.nthreads = nthreads;
+    ctx.mem_node = mem_node;
+    ctx.t_start = gettime();
+    ctx.speed = (double *)calloc(nthreads, sizeof(double));
+    ctx.best_speed = (double *)calloc(nthreads, sizeof(double));
+    spin_barrier_init(&ctx.barrier, nthreads);
+
+    if (!ctx.speed || !ctx.best_speed ||
+        !run_threads(nthreads, cpus, ncpus, mt_bandwidth_thread, &ctx))
+    {
+        free(ctx.speed);
+        free(ctx.best_speed);
+        return -1;
+    }
+    if (ctx.alloc_failed)
+    {
+        free(ctx.speed);
+        free(ctx.best_speed);
+        return -2;
+    }
+
+    *minspeed = *maxspeed = ctx.best_speed[0];
+    for (i = 1; i < nthreads; i++)
+    {
+        if (ctx.best_speed[i] < *minspeed)
+            *minspeed = ctx.best_speed[i];
+        if (ctx.best_speed[i] > *maxspeed)
+            *maxspeed = ctx.best_speed[i];
+    }
+
+    measurement_from_samples(m, ctx.samples, ctx.s0, 1);
+    free(ctx.speed);
+    free(ctx.best_speed);
+    return ctx.maxspeed;
+}
+
+static double mt_bandwidth_bench_helper(int nthreads, const int *cpus, int ncpus,
+                                        int size, int blocksize,
+                                        const char *indent_prefix,
+                                        int use_tmpbuf,
+                                        void (*f)(int64_t *, int64_t *, int),
+                                        const char *description)
+{
+    double speed, minspeed, maxspeed;
+    measurement m;
+
+    speed = mt_bandwidth_measure(nthreads, cpus, ncpus, -1, size, blocksize,
+                                 use_tmpbuf, f, &minspeed, &maxspeed, &m);
+    if (speed == -2)
+    {
+        printf("%s%4d thread%s : failed to allocate the buffers in the selected huge pages mode\n",
+               indent_prefix, nthreads, nthreads == 1 ? " " : "s");
+        return speed;
+    }
+    if (speed < 0)
+    {
+        printf("%s%4d thread%s : failed to run\n", indent_prefix, nthreads,
+               nthreads == 1 ? " " : "s");
+        return speed;
+    }
+
+    report_add("multi-threaded bandwidth", description, size, nthreads, &m,
+               "MB/s", buffer_page_mode());
+    printf("%s%4d thread%s : %9.1f MB/s (per thread: %8.1f avg, %8.1f min, %8.1f max)\n",
+           indent_prefix, nthreads, nthreads == 1 ? " " : "s", speed,
+           speed / nthreads, minspeed, maxspeed);
+    return speed;
+}
+
+/*
+ * Run each benchmark on 1, 2, 4, ... 'maxthreads' threads, pinned to
+ * different CPUs, and report the aggregate bandwidth for each thread count.
+ */
+void mt_bandwidth_bench(int maxthreads, const int *cpus, int ncpus,
+                        int size, int blocksize, const char *indent_prefix,
+                        bench_info *bi)
 {
+    int nthreads;
     while (bi->f)
     {
-        bandwidth_bench_helper(dstbuf, srcbuf, tmpbuf, size, blocksize,
-                               indent_prefix, bi->use_tmpbuf,
-                               bi->f,
-                               bi->description);
+        if (!kernel_selected(bi->description))
+        {
+            bi++;
+            continue;
+        }
+        printf("%s%s\n", indent_prefix, bi->description);
+        for (nthreads = 1; ; nthreads *= 2)
+        {
+            if (nthreads > maxthreads)
+                nthreads = maxthreads;
+            /* More threads would not get the buffers either */
+            if (mt_bandwidth_bench_helper(nthreads, cpus, ncpus, size,
+                                          blocksize, "     ", bi->use_tmpbuf,
+                                          bi->f, bi->description) == -2)
+                break;
+            if (nthreads == maxthreads)
+                break;
+        }
         bi++;
     }
 }
 
+/*
+ * Contended atomic operations. Every thread keeps updating its counter,
+ * which is either shared by all the threads, or placed next to the other
+ * threads' counters in the same cache line (false sharing), or has a cache
+ * line of its own.
+ */
+
+#define ATOMIC_BATCH    1024
+#define ATOMIC_PADDING  128
+/* The number of the counters, which fit in one 64-byte cache line */
+#define ATOMIC_FALSE_SHARING_MAX (64 / (int)sizeof(long))
+
+enum
+{
+    ATOMIC_FETCH_ADD,
+    ATOMIC_CAS_LOOP,
+    ATOMIC_STORE,
+    ATOMIC_NUM_OPS
+};
+
+enum
+{
+    ATOMIC_SAME_LINE,
+    ATOMIC_FALSE_SHARING,
+    ATOMIC_PADDED,
+    ATOMIC_NUM_PLACEMENTS
+};
+
+static const char *atomic_op_names[ATOMIC_NUM_OPS] =
+{
+    "fetch-add", "CAS loop", "store"
+};
+
+static const char *atomic_placement_names[ATOMIC_NUM_PLACEMENTS] =
+{
+    "same line", "false sharing", "padded"
+};
+
+typedef struct
+{
+    int             op;
+    int             placement;
+    int             nthreads;
+    char           *counters;
+    spin_barrier_t  barrier;
+    volatile int    stop;
+    volatile int    done;
+    double         *ops;
+    double         *best_ops;
+    double          maxops;
+    double          s0, s1, s2;
+    double          t_start;
+    double          samples[MAX_SAMPLES];
+} atomic_ctx;
+
+static void __attribute__((noinline)) atomic_ops(long *p, int op,
+                                                 int count)
+{
+    long v;
+    int i;
+
+    switch (op)
+    {
+    case ATOMIC_FETCH_ADD:
+        for (i = 0; i < count; i++)
+            __atomic_fetch_add(p, 1, __ATOMIC_RELAXED);
+        break;
+    case ATOMIC_CAS_LOOP:
+        for (i = 0; i < count; i++)
+        {
+            v = __atomic_load_n(p, __ATOMIC_RELAXED);
+            while (!__atomic_compare_exchange_n(p, &v, v + 1, 1,
+                                                __ATOMIC_RELAXED,
+                                                __ATOMIC_RELAXED))
+            {
+            }
+        }
+        break;
+    case ATOMIC_STORE:
+        for (i = 0; i < count; i++)
+            __atomic_store_n(p, i, __ATOMIC_RELAXED);
+        break;
+    }
+}
+
+static void atomic_thread(int thread_index, int cpu, void *arg)
+{
+    atomic_ctx *ctx = (atomic_ctx *)arg;
+    long *p = (long *)ctx->counters;
+    int64_t count;
+    int i, n;
+    double t1, t2, ops, s;
+
+    if (ctx->placement == ATOMIC_FALSE_SHARING)
+        p += thread_index;
+    else if (ctx->placement == ATOMIC_PADDED)
+        p = (long *)(ctx->counters + thread_index * ATOMIC_PADDING);
+
+    for (n = 0; n < cfg.maxrepeats; n++)
+    {
+        spin_barrier_wait(&ctx->barrier);
+
+        count = 0;
+        t1 = gettime();
+        do
+        {
+            atomic_ops(p, ctx->op, ATOMIC_BATCH);
+            count += ATOMIC_BATCH;
+            if (thread_index == 0 && gettime() - t1 >= cfg.sample_time)
+                ctx->stop = 1;
+        } while (!ctx->stop);
+        t2 = gettime();
+        ctx->ops[thread_index] = (double)count / (t2 - t1) / 1000000.;
+
+        spin_barrier_wait(&ctx->barrier);
+        if (thread_index == 0)
+        {
+            ops = 0;
+            for (i = 0; i < ctx->nthreads; i++)
+                ops += ctx->ops[i];
+
+            ctx->samples[n] = ops;
+            ctx->s0 += 1;
+            ctx->s1 += ops;
+            ctx->s2 += ops * ops;
+
+            if (ops > ctx->maxops)
+            {
+                ctx->maxops = ops;
+                memcpy(ctx->best_ops, ctx->ops,
+                       ctx->nthreads * sizeof(double));
+            }
+
+            if (ctx->s0 > 2)
+            {
+                s = sqrt((ctx->s0 * ctx->s2 - ctx->s1 * ctx->s1) /
+                         (ctx->s0 * (ctx->s0 - 1)));
+                if (s < ctx->maxops / 1000.)
+                    ctx->done = 1;
+            }
+            if (out_of_time(ctx->t_start))
+                ctx->done = 1;
+            ctx->stop = 0;
+        }
+        spin_barrier_wait(&ctx->barrier);
+        if (ctx->done)
+            break;
+    }
+}
+
+/*
+ * Run the atomic operation 'op' on 'nthreads' threads simultaneously and
+ * return the best total number of operations per second (in millions), or
+ * a negative value on failure. The per-thread numbers of the best run are
+ * returned via 'per_thread', the summary of the measurements via 'm'.
+ */
+static double atomic_measure(int nthreads, const int *cpus, int ncpus,
+                             int op, int placement, double *per_thread,
+                             measurement *m)
+{
+    atomic_ctx ctx;
+    int ok;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.op = op;
+    ctx.placement = placement;
+    ctx.nthreads = nthreads;
+    ctx.t_start = gettime();
+    ctx.ops = (double *)calloc(nthreads, sizeof(double));
+    ctx.best_ops = per_thread;
+    spin_barrier_init(&ctx.barrier, nthreads);
+
+    /* Page aligned, so every padded counter has a cache line of its own */
+    ctx.counters = (char *)alloc_pages(nthreads * ATOMIC_PADDING,
+                                       PAGES_DEFAULT);
+    if (ctx.counters)
+        memset(ctx.counters, 0, nthreads * ATOMIC_PADDING);
+
+    ok = ctx.ops && ctx.counters &&
+         run_threads(nthreads, cpus, ncpus, atomic_thread, &ctx);
+    if (ok)
+        measurement_from_samples(m, ctx.samples, ctx.s0, 1);
+    free(ctx.ops);
+    free_pages(ctx.counters);
+    return ok ? ctx.maxops : -1;
+}
+
+/*
+ * Run every atomic operation with every counter placement on 1, 2, 4, ...
+ * 'maxthreads' threads. The fairness is Jain's index of the per-thread
+ * numbers of operations (1.0 means that all the threads got an equal share).
+ */
+void atomic_bench(int maxthreads, const int *cpus, int ncpus,
+                  const char *indent_prefix)
+{
+    double *per_thread = (double *)calloc(maxthreads, sizeof(double));
+    double ops, minops, maxops, s1, s2, fairness;
+    measurement m;
+    char name[64];
+    int op, placement, nthreads, limit, i;
+
+    if (!per_thread)
+        return;
+
+    for (op = 0; op < ATOMIC_NUM_OPS; op++)
+    {
+        for (placement = 0; placement < ATOMIC_NUM_PLACEMENTS; placement++)
+        {
+            sprintf(name, "%s, %s", atomic_op_names[op],
+                    atomic_placement_names[placement]);
+            /* More threads would spill the counters into the next line */
+            limit = maxthreads;
+            if (placement == ATOMIC_FALSE_SHARING &&
+                limit > ATOMIC_FALSE_SHARING_MAX)
+                limit = ATOMIC_FALSE_SHARING_MAX;
+            if (limit < maxthreads)
+                printf("%s%s (at most %d counters fit in a cache line)\n",
+                       indent_prefix, name, limit);
+            else
+                printf("%s%s\n", indent_prefix, name);
+            for (nthreads = 1; ; nthreads *= 2)
+            {
+                if (nthreads > limit)
+                    nthreads = limit;
+                ops = atomic_measure(nthreads, cpus, ncpus, op, placement,
+                                     per_thread, &m);
+                if (ops < 0)
+                {
+                    printf("%s    %4d thread%s : failed to run\n",
+                           indent_prefix, nthreads, nthreads == 1 ? " " : "s");
+                }
+                else
+                {
+                    minops = maxops = per_thread[0];
+                    s1 = s2 = 0;
+                    for (i = 0; i < nthreads; i++)
+                    {
+                        if (per_thread[i] < minops)
+                            minops = per_thread[i];
+                        if (per_thread[i] > maxops)
+                            maxops = per_thread[i];
+                        s1 += per_thread[i];
+                        s2 += per_thread[i] * per_thread[i];
+                    }
+                    fairness = s2 > 0 ? s1 * s1 / (nthreads * s2) : 0;
+                    report_add("atomic contention", name, 0, nthreads, &m,
+                               "Mops/s", PAGES_DEFAULT);
+                    m.best = m.median = fairness;
+                    m.stddev = 0;
+                    report_add("atomic contention", name, 0, nthreads, &m,
+                               "fairness", PAGES_DEFAULT);
+                    printf("%s    %4d thread%s : %8.1f Mops/s (per thread: "
+                           "%7.1f min, %7.1f max, fairness %.3f)\n",
+                           indent_prefix, nthreads, nthreads == 1 ? " " : "s",
+                           ops, minops, maxops, fairness);
+                }
+                if (nthreads == limit)
+                    break;
+            }
+        }
+    }
+    free(per_thread);
+}
+
 static void __attribute__((noinline)) random_read_test(char *zerobuffer,
                                                        int count, int nbits)
 {
@@ -375,214 +1143,3205 @@ static uint32_t rand32()
     return (hi << 16) + lo;
 }
 
-int latency_bench(int size, int count, int use_hugepage)
+/*
+ * Measure the time spent in the random read tests when all the accesses
+ * hit the same cache line. This is the overhead of the address calculation,
+ * which is later subtracted from the results.
+ */
+static void latency_bench_noaccess(char *buffer, int count,
+                                   double *t_noaccess, double *t_noaccess2)
 {
-    double t, t2, t_before, t_after, t_noaccess, t_noaccess2;
-    double xs, xs0, xs1, xs2;
-    double ys, ys0, ys1, ys2;
-    double min_t, min_t2;
-    int nbits, n;
-    char *buffer, *buffer_alloc;
-#if !defined(__linux__) || !defined(MADV_HUGEPAGE)
-    if (use_hugepage)
-        return 0;
-    buffer_alloc = (char *)malloc(size + 4095);
-    if (!buffer_alloc)
-        return 0;
-    buffer = (char *)(((uintptr_t)buffer_alloc + 4095) & ~(uintptr_t)4095);
-#else
-    if (posix_memalign((void **)&buffer_alloc, 4 * 1024 * 1024, size) != 0)
-        return 0;
-    buffer = buffer_alloc;
-    if (use_hugepage && madvise(buffer, size, use_hugepage > 0 ?
-                                MADV_HUGEPAGE : MADV_NOHUGEPAGE) != 0)
+    double t_before, t_after;
+    int n;
+
+    for (n = 1; n <= cfg.maxrepeats; n++)
     {
-        free(buffer_alloc);
-        return 0;
+        t_before = gettime();
+        random_read_test(buffer, count, 1);
+        t_after = gettime();
+        if (n == 1 || t_after - t_before < *t_noaccess)
+            *t_noaccess = t_after - t_before;
+
+        t_before = gettime();
+        random_dual_read_test(buffer, count, 1);
+        t_after = gettime();
+        if (n == 1 || t_after - t_before < *t_noaccess2)
+            *t_noaccess2 = t_after - t_before;
     }
-#endif
-    memset(buffer, 0, size);
+}
+
+/*
+ * Measure the extra time (in nanoseconds) needed for single and dual
+ * random reads within a block of (1 << nbits) bytes somewhere in the buffer.
+ */
+static void latency_bench_measure(char *buffer, int size, int count, int nbits,
+                                  double t_noaccess, double t_noaccess2,
+                                  measurement *latency, measurement *latency2)
+{
+    double t, t2, t_before, t_after;
+    double xs, xs1, xs2;
+    double ys, ys1, ys2;
+    double min_t, min_t2, t_start;
+    double samples[MAX_SAMPLES], samples2[MAX_SAMPLES];
+    int testsize = 1 << nbits;
+    int n;
 
-    for (n = 1; n <= MAXREPEATS; n++)
+    xs1 = xs2 = ys = ys1 = ys2 = 0;
+    perf_reset();
+    t_start = gettime();
+    for (n = 1; n <= cfg.maxrepeats; n++)
     {
+        /*
+         * Select a random offset in order to mitigate the unpredictability
+         * of cache associativity effects when dealing with different
+         * physical memory fragmentation (for PIPT caches). We are reporting
+         * the "best" measured latency, some offsets may be better than
+         * the others.
+         */
+        int testoffs = (rand32() % (size / testsize)) * testsize;
+
+        perf_start();
         t_before = gettime();
-        random_read_test(buffer, count, 1);
+        random_read_test(buffer + testoffs, count, nbits);
         t_after = gettime();
-        if (n == 1 || t_after - t_before < t_noaccess)
-            t_noaccess = t_after - t_before;
+        perf_stop(count);
+        t = t_after - t_before - t_noaccess;
+        if (t < 0) t = 0;
+        samples[n - 1] = t * 1000000000. / count;
+
+        xs1 += t;
+        xs2 += t * t;
+
+        if (n == 1 || t < min_t)
+            min_t = t;
 
         t_before = gettime();
-        random_dual_read_test(buffer, count, 1);
+        random_dual_read_test(buffer + testoffs, count, nbits);
         t_after = gettime();
-        if (n == 1 || t_after - t_before < t_noaccess2)
-            t_noaccess2 = t_after - t_before;
+        t2 = t_after - t_before - t_noaccess2;
+        if (t2 < 0) t2 = 0;
+        samples2[n - 1] = t2 * 1000000000. / count;
+
+        ys1 += t2;
+        ys2 += t2 * t2;
+
+        if (n == 1 || t2 < min_t2)
+            min_t2 = t2;
+
+        if (n > 2)
+        {
+            xs = sqrt((xs2 * n - xs1 * xs1) / (n * (n - 1)));
+            ys = sqrt((ys2 * n - ys1 * ys1) / (n * (n - 1)));
+            if (xs < min_t / 1000. && ys < min_t2 / 1000.)
+                break;
+        }
+        if (out_of_time(t_start))
+            break;
     }
+    if (n > cfg.maxrepeats)
+        n = cfg.maxrepeats;
+    measurement_from_samples(latency, samples, n, 0);
+    measurement_from_samples(latency2, samples2, n, 0);
+}
 
-    printf("\nblock size : single random read / dual random read");
-    if (use_hugepage > 0)
-        printf(", [MADV_HUGEPAGE]\n");
-    else if (use_hugepage < 0)
-        printf(", [MADV_NOHUGEPAGE]\n");
+/*
+ * Allocate a zero filled buffer for the latency tests, backed by the pages
+ * selected by 'use_hugepage' (a page mode from alloc.h). Returns the pointer
+ * to be freed later by free_pages() or NULL on failure.
+ */
+static char *alloc_latency_buffer(int64_t size, int use_hugepage,
+                                  char **buffer)
+{
+    char *buffer_alloc = (char *)alloc_pages(size, use_hugepage);
+    if (!buffer_alloc)
+        return NULL;
+    *buffer = buffer_alloc;
+    memset(*buffer, 0, size);
+    return buffer_alloc;
+}
+
+static void print_hugepage_mode(int use_hugepage)
+{
+    if (use_hugepage != PAGES_DEFAULT)
+        printf(", [%s]\n", page_mode_description(use_hugepage));
     else
         printf("\n");
+}
+
+int latency_bench(int size, int count, int use_hugepage)
+{
+    double t_noaccess, t_noaccess2;
+    measurement latency, latency2;
+    int nbits;
+    char *buffer, *buffer_alloc;
+
+    buffer_alloc = alloc_latency_buffer(size, use_hugepage, &buffer);
+    if (!buffer_alloc)
+        return 0;
+
+    latency_bench_noaccess(buffer, count, &t_noaccess, &t_noaccess2);
+
+    printf("\nblock size : single random read / dual random read");
+    print_hugepage_mode(use_hugepage);
+
+    for (nbits = 10; (1 << nbits) <= size; nbits++)
+    {
+        latency_bench_measure(buffer, size, count, nbits,
+                              t_noaccess, t_noaccess2, &latency, &latency2);
+        report_add("latency", "single random read", 1 << nbits, 1, &latency,
+                   "ns", use_hugepage);
+        report_add("latency", "dual random read", 1 << nbits, 1, &latency2,
+                   "ns", use_hugepage);
+        printf("%10d : %6.1f ns          /  %6.1f ns \n", (1 << nbits),
+            latency.best, latency2.best);
+        /* Only the single random read is counted */
+        perf_print("             ", "access");
+        perf_report("latency", "single random read", 1 << nbits, "access",
+                    use_hugepage);
+    }
+    free_pages(buffer_alloc);
+    return 1;
+}
+
+#define POINTER_CHASE_STRIDE 64
+
+/*
+ * Link all the cache lines of the block into a single random cycle, using
+ * Sattolo's algorithm. The first bytes of each cache line contain a pointer
+ * to the next cache line in the cycle.
+ */
+static void pointer_chase_init(char *block, int blocksize, uint32_t *perm)
+{
+    int nlines = blocksize / POINTER_CHASE_STRIDE;
+    int i, j;
+    uint32_t tmp;
+
+    for (i = 0; i < nlines; i++)
+        perm[i] = i;
+    for (i = nlines - 1; i > 0; i--)
+    {
+        j = rand32() % i;
+        tmp = perm[i];
+        perm[i] = perm[j];
+        perm[j] = tmp;
+    }
+    for (i = 0; i < nlines; i++)
+        *(char **)(block + i * POINTER_CHASE_STRIDE) =
+                                    block + perm[i] * POINTER_CHASE_STRIDE;
+}
+
+/*
+ * Every load depends on the result of the previous one, there is no
+ * extra arithmetics involved.
+ */
+static void * __attribute__((noinline)) pointer_chase_test(void *p, int count)
+{
+    void **ptr = (void **)p;
+    while (count >= 16) {
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        ptr = (void **)*ptr;
+        count -= 16;
+    }
+    return ptr;
+}
+
+/*
+ * Measure the time (in nanoseconds) needed for a single hop of pointer
+ * chasing in a random cycle covering a block of 'testsize' bytes (a multiple
+ * of the cache line size) somewhere in the buffer. The best result is
+ * returned, the summary of all the measurements is stored in 'm'.
+ */
+static double pointer_chase_measure(char *buffer, int size, int count,
+                                    int testsize, uint32_t *perm,
+                                    measurement *m)
+{
+    static void * volatile dummy;
+    double t, t_before, t_after;
+    double xs, xs1, xs2, min_t, t_start;
+    double samples[MAX_SAMPLES];
+    int n;
+
+    xs1 = xs2 = 0;
+    perf_reset();
+    t_start = gettime();
+    for (n = 1; n <= cfg.maxrepeats; n++)
+    {
+        /* Random offset for the same reasons as in latency_bench_measure */
+        char *block = buffer + (rand32() % (size / testsize)) * testsize;
+        pointer_chase_init(block, testsize, perm);
+        /* Warm up the caches and TLB */
+        dummy = pointer_chase_test(block, testsize / POINTER_CHASE_STRIDE);
+
+        perf_start();
+        t_before = gettime();
+        dummy = pointer_chase_test(block, count);
+        t_after = gettime();
+        perf_stop(count);
+        t = t_after - t_before;
+        samples[n - 1] = t * 1000000000. / count;
+
+        xs1 += t;
+        xs2 += t * t;
+
+        if (n == 1 || t < min_t)
+            min_t = t;
+
+        if (n > 2)
+        {
+            xs = sqrt((xs2 * n - xs1 * xs1) / (n * (n - 1)));
+            if (xs < min_t / 1000.)
+                break;
+        }
+        if (out_of_time(t_start))
+            break;
+    }
+    measurement_from_samples(m, samples,
+                             n > cfg.maxrepeats ? cfg.maxrepeats : n, 0);
+    return min_t * 1000000000. / count;
+}
+
+int pointer_chase_bench(int size, int count, int use_hugepage)
+{
+    measurement m;
+    int nbits;
+    char *buffer, *buffer_alloc;
+    uint32_t *perm;
+
+    perm = (uint32_t *)malloc(size / POINTER_CHASE_STRIDE * sizeof(uint32_t));
+    if (!perm)
+        return 0;
+    buffer_alloc = alloc_latency_buffer(size, use_hugepage, &buffer);
+    if (!buffer_alloc)
+    {
+        free(perm);
+        return 0;
+    }
+
+    printf("\nblock size : pointer chasing latency");
+    print_hugepage_mode(use_hugepage);
 
     for (nbits = 10; (1 << nbits) <= size; nbits++)
     {
-        int testsize = 1 << nbits;
-        xs1 = xs2 = ys = ys1 = ys2 = 0;
-        for (n = 1; n <= MAXREPEATS; n++)
+        pointer_chase_measure(buffer, size, count, 1 << nbits, perm, &m);
+        report_add("latency", "pointer chasing", 1 << nbits, 1, &m, "ns",
+                   use_hugepage);
+        printf("%10d : %6.1f ns\n", (1 << nbits), m.best);
+        perf_print("             ", "access");
+        perf_report("latency", "pointer chasing", 1 << nbits, "access",
+                    use_hugepage);
+        fflush(stdout);
+    }
+    free_pages(buffer_alloc);
+    free(perm);
+    return 1;
+}
+
+#define MAX_CHAINS 32
+
+/*
+ * Walk 'nchains' independent chains at once, 'count' loads in total. With
+ * a constant 'nchains' the compiler keeps the cursors in registers.
+ */
+static inline __attribute__((always_inline)) void *
+multi_chase(void **cursors, int nchains, int count)
+{
+    void **c[MAX_CHAINS];
+    int i;
+    for (i = 0; i < nchains; i++)
+        c[i] = (void **)cursors[i];
+    while (count >= nchains * 4) {
+        for (i = 0; i < nchains; i++)
+            c[i] = (void **)*c[i];
+        for (i = 0; i < nchains; i++)
+            c[i] = (void **)*c[i];
+        for (i = 0; i < nchains; i++)
+            c[i] = (void **)*c[i];
+        for (i = 0; i < nchains; i++)
+            c[i] = (void **)*c[i];
+        count -= nchains * 4;
+    }
+    for (i = 1; i < nchains; i++)
+        c[0] = (void **)((uintptr_t)c[0] ^ (uintptr_t)c[i]);
+    return c[0];
+}
+
+#define DEFINE_MULTI_CHASE(n)                                            \
+    static void * __attribute__((noinline))                              \
+    multi_chase_##n(void **cursors, int count)                           \
+    {                                                                    \
+        return multi_chase(cursors, n, count);                           \
+    }
+
+DEFINE_MULTI_CHASE(1)
+DEFINE_MULTI_CHASE(2)
+DEFINE_MULTI_CHASE(4)
+DEFINE_MULTI_CHASE(8)
+DEFINE_MULTI_CHASE(16)
+DEFINE_MULTI_CHASE(32)
+
+static struct
+{
+    int nchains;
+    void *(*f)(void **, int);
+} multi_chase_tests[] =
+{
+    { 1, multi_chase_1 },
+    { 2, multi_chase_2 },
+    { 4, multi_chase_4 },
+    { 8, multi_chase_8 },
+    { 16, multi_chase_16 },
+    { 32, multi_chase_32 },
+    { 0, NULL }
+};
+
+/*
+ * Measure the average time (in nanoseconds) per access, when 'nchains'
+ * pointer chasing chains are walked simultaneously in a random cycle,
+ * covering a block of (1 << nbits) bytes somewhere in the buffer. The
+ * chains start at evenly spaced positions of the same cycle, so they
+ * are independent from each other.
+ */
+static double mlp_measure(char *buffer, int size, int count, int nbits,
+                          uint32_t *perm, int nchains,
+                          void *(*f)(void **, int), measurement *m)
+{
+    static void * volatile dummy;
+    void *cursors[MAX_CHAINS];
+    double t, t_before, t_after;
+    double xs, xs1, xs2, min_t, t_start;
+    double samples[MAX_SAMPLES];
+    int testsize = 1 << nbits;
+    int nlines = testsize / POINTER_CHASE_STRIDE;
+    int i, n;
+    void **p;
+
+    xs1 = xs2 = 0;
+    t_start = gettime();
+    for (n = 1; n <= cfg.maxrepeats; n++)
+    {
+        char *block = buffer + (rand32() % (size / testsize)) * testsize;
+        pointer_chase_init(block, testsize, perm);
+
+        p = (void **)block;
+        for (i = 0; i < nlines; i++)
         {
-            /*
-             * Select a random offset in order to mitigate the unpredictability
-             * of cache associativity effects when dealing with different
-             * physical memory fragmentation (for PIPT caches). We are reporting
-             * the "best" measured latency, some offsets may be better than
-             * the others.
-             */
-            int testoffs = (rand32() % (size / testsize)) * testsize;
+            if (i % (nlines / nchains) == 0 && i / (nlines / nchains) < nchains)
+                cursors[i / (nlines / nchains)] = p;
+            p = (void **)*p;
+        }
+
+        t_before = gettime();
+        dummy = f(cursors, count);
+        t_after = gettime();
+        t = t_after - t_before;
+        samples[n - 1] = t * 1000000000. / count;
 
-            t_before = gettime();
-            random_read_test(buffer + testoffs, count, nbits);
-            t_after = gettime();
-            t = t_after - t_before - t_noaccess;
-            if (t < 0) t = 0;
+        xs1 += t;
+        xs2 += t * t;
 
-            xs1 += t;
-            xs2 += t * t;
+        if (n == 1 || t < min_t)
+            min_t = t;
 
-            if (n == 1 || t < min_t)
-                min_t = t;
+        if (n > 2)
+        {
+            xs = sqrt((xs2 * n - xs1 * xs1) / (n * (n - 1)));
+            if (xs < min_t / 1000.)
+                break;
+        }
+        if (out_of_time(t_start))
+            break;
+    }
+    measurement_from_samples(m, samples,
+                             n > cfg.maxrepeats ? cfg.maxrepeats : n, 0);
+    return min_t * 1000000000. / count;
+}
 
-            t_before = gettime();
-            random_dual_read_test(buffer + testoffs, count, nbits);
-            t_after = gettime();
-            t2 = t_after - t_before - t_noaccess2;
-            if (t2 < 0) t2 = 0;
+int mlp_bench(int size, int count, int use_hugepage)
+{
+    int nbits, k;
+    char *buffer, *buffer_alloc;
+    uint32_t *perm;
+    double latency, latency1;
+    measurement m;
+    char name[32];
 
-            ys1 += t2;
-            ys2 += t2 * t2;
+    perm = (uint32_t *)malloc(size / POINTER_CHASE_STRIDE * sizeof(uint32_t));
+    if (!perm)
+        return 0;
+    buffer_alloc = alloc_latency_buffer(size, use_hugepage, &buffer);
+    if (!buffer_alloc)
+    {
+        free(perm);
+        return 0;
+    }
 
-            if (n == 1 || t2 < min_t2)
-                min_t2 = t2;
+    printf("\nblock size : ns per access (MLP) for N simultaneous chains");
+    print_hugepage_mode(use_hugepage);
+    printf("%10s :", "");
+    for (k = 0; multi_chase_tests[k].f; k++)
+        printf("     N=%-2d      ", multi_chase_tests[k].nchains);
+    printf("\n");
 
-            if (n > 2)
+    for (nbits = 10; (1 << nbits) <= size; nbits++)
+    {
+        printf("%10d :", (1 << nbits));
+        latency1 = 0;
+        for (k = 0; multi_chase_tests[k].f; k++)
+        {
+            int nchains = multi_chase_tests[k].nchains;
+            if (nchains > (1 << nbits) / POINTER_CHASE_STRIDE)
             {
-                xs = sqrt((xs2 * n - xs1 * xs1) / (n * (n - 1)));
-                ys = sqrt((ys2 * n - ys1 * ys1) / (n * (n - 1)));
-                if (xs < min_t / 1000. && ys < min_t2 / 1000.)
-                    break;
+                printf(" %14s", "-");
+                continue;
             }
+            latency = mlp_measure(buffer, size, count, nbits, perm, nchains,
+                                  multi_chase_tests[k].f, &m);
+            sprintf(name, "%d chain%s", nchains, nchains == 1 ? "" : "s");
+            report_add("mlp", name, 1 << nbits, 1, &m, "ns", use_hugepage);
+            if (nchains == 1)
+                latency1 = latency;
+            printf(" %6.1f (%5.1f)", latency,
+                   latency > 0 ? latency1 / latency : 0);
+            fflush(stdout);
         }
-        printf("%10d : %6.1f ns          /  %6.1f ns \n", (1 << nbits),
-            min_t * 1000000000. / count,  min_t2 * 1000000000. / count);
+        printf("\n");
     }
-    free(buffer_alloc);
+    free_pages(buffer_alloc);
+    free(perm);
     return 1;
 }
 
-int main(void)
+#define CACHE_DETECT_MIN_SIZE  (4 * 1024)
+#define CACHE_DETECT_MAX_SIZE  (256 * 1024 * 1024)
+#define CACHE_DETECT_STEPS     4
+#define CACHE_DETECT_MAXPOINTS 128
+
+/*
+ * Measure the pointer chasing latency for all the block sizes.
+ * Returns 0 if the buffer can't be allocated with the requested
+ * huge pages mode.
+ */
+static int measure_latency_curve(int size, int count, int use_hugepage,
+                                 const int *sizes, int npoints,
+                                 double *latency)
 {
-    int latbench_size = SIZE * 2, latbench_count = LATBENCH_COUNT;
-    int64_t *srcbuf, *dstbuf, *tmpbuf;
-    void *poolbuf;
-    size_t bufsize = SIZE;
-#ifdef __linux__
-    size_t fbsize = 0;
-    int64_t *fbbuf = mmap_framebuffer(&fbsize);
-    fbsize = (fbsize / BLOCKSIZE) * BLOCKSIZE;
-#endif
+    char *buffer, *buffer_alloc;
+    uint32_t *perm;
+    measurement m;
+    int i;
 
-    printf("tinymembench v" VERSION " (simple benchmark for memory throughput and latency)\n");
+    perm = (uint32_t *)malloc(size / POINTER_CHASE_STRIDE * sizeof(uint32_t));
+    if (!perm)
+        return 0;
+    buffer_alloc = alloc_latency_buffer(size, use_hugepage, &buffer);
+    if (!buffer_alloc)
+    {
+        free(perm);
+        return 0;
+    }
+    for (i = 0; i < npoints; i++)
+    {
+        latency[i] = pointer_chase_measure(buffer, size, count, sizes[i],
+                                           perm, &m);
+        report_add("cache detection", "pointer chasing", sizes[i], 1, &m,
+                   "ns", use_hugepage);
+    }
+    free_pages(buffer_alloc);
+    free(perm);
+    return 1;
+}
+
+/*
+ * Find the steps in the pointer chasing latency curve, which correspond
+ * to the cache levels, and the extra latency caused by TLB misses (the
+ * difference between the curves with 4 KiB pages and huge pages).
+ */
+static void cache_detect_thread(int thread_index, int cpu, void *arg)
+{
+    int count = *(int *)arg;
+    int sizes[CACHE_DETECT_MAXPOINTS];
+    double latency_hp[CACHE_DETECT_MAXPOINTS];
+    double latency_4k[CACHE_DETECT_MAXPOINTS];
+    double extra[CACHE_DETECT_MAXPOINTS];
+    curve_step steps[16];
+    sysfs_cache_info caches[16];
+    char buf1[32], buf2[32];
+    double *latency;
+    measurement m;
+    int i, k, npoints = 0, nsteps, ncaches, have_hp, have_4k, hp_mode, mode;
+    int64_t blocksize;
 
+    for (blocksize = CACHE_DETECT_MIN_SIZE;
+         blocksize <= CACHE_DETECT_MAX_SIZE; blocksize *= 2)
+    {
+        for (k = 0; k < CACHE_DETECT_STEPS; k++)
+        {
+            int64_t testsize = blocksize + blocksize * k / CACHE_DETECT_STEPS;
+            if (testsize <= CACHE_DETECT_MAX_SIZE &&
+                npoints < CACHE_DETECT_MAXPOINTS)
+                sizes[npoints++] = testsize;
+        }
+    }
 
-    poolbuf = alloc_four_nonaliased_buffers((void **)&srcbuf, bufsize,
-                                            (void **)&dstbuf, bufsize,
-                                            (void **)&tmpbuf, BLOCKSIZE,
-                                            NULL, 0);
     printf("\n");
     printf("==========================================================================\n");
-    printf("== Memory bandwidth tests                                               ==\n");
+    printf("== Cache hierarchy detection                                            ==\n");
     printf("==                                                                      ==\n");
-    printf("== Note 1: 1MB = 1000000 bytes                                          ==\n");
-    printf("== Note 2: Results for 'copy' tests show how many bytes can be          ==\n");
-    printf("==         copied per second (adding together read and writen           ==\n");
-    printf("==         bytes would have provided twice higher numbers)              ==\n");
-    printf("== Note 3: 2-pass copy means that we are using a small temporary buffer ==\n");
-    printf("==         to first fetch data into it, and only then write it to the   ==\n");
-    printf("==         destination (source -> L1 cache, L1 cache -> destination)    ==\n");
-    printf("== Note 4: If sample standard deviation exceeds 0.1%%, it is shown in    ==\n");
-    printf("==         brackets                                                     ==\n");
+    printf("== The pointer chasing latency is measured for the block sizes from     ==\n");
+    printf("== 4 KiB to 256 MiB (with 4 steps per each doubling of the size), both  ==\n");
+    printf("== with huge pages and 4 KiB pages. The flat parts of the huge pages    ==\n");
+    printf("== curve are reported as the cache levels, the steps in the difference  ==\n");
+    printf("== between the two curves show the TLB reach.                           ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Note: The detected cache sizes are the largest block sizes, which    ==\n");
+    printf("==       still have the same latency. Because of the associativity and  ==\n");
+    printf("==       replacement policy effects, they are usually a bit smaller     ==\n");
+    printf("==       than the real sizes reported by the system (if available).     ==\n");
     printf("==========================================================================\n\n");
 
-    bandwidth_bench(dstbuf, srcbuf, tmpbuf, bufsize, BLOCKSIZE, " ", c_benchmarks);
-    printf(" ---\n");
-    bandwidth_bench(dstbuf, srcbuf, tmpbuf, bufsize, BLOCKSIZE, " ", libc_benchmarks);
-    bench_info *bi = get_asm_benchmarks();
-    if (bi->f) {
-        printf(" ---\n");
-        bandwidth_bench(dstbuf, srcbuf, tmpbuf, bufsize, BLOCKSIZE, " ", bi);
+    /*
+     * With --hugepage only the selected kind of pages is used (and 4 KiB
+     * pages as the reference for the TLB reach if it is a huge page mode)
+     */
+    hp_mode = cfg.hugepage == HUGEPAGE_AUTO ? PAGES_THP : cfg.hugepage;
+    have_hp = hp_mode != PAGES_4K &&
+              measure_latency_curve(CACHE_DETECT_MAX_SIZE, count, hp_mode,
+                                    sizes, npoints, latency_hp);
+    if (cfg.hugepage != HUGEPAGE_AUTO && cfg.hugepage != PAGES_4K && !have_hp)
+    {
+        printf(" Failed to allocate the buffer in the selected huge pages mode.\n");
+        return;
     }
+    have_4k = cfg.hugepage != PAGES_DEFAULT &&
+              measure_latency_curve(CACHE_DETECT_MAX_SIZE, count, PAGES_4K,
+                                    sizes, npoints, latency_4k);
+    if (!have_hp && !have_4k)
+    {
+        if (cfg.hugepage != HUGEPAGE_AUTO)
+        {
+            printf(" Failed to allocate the buffer in the selected huge pages mode.\n");
+            return;
+        }
+        if (!measure_latency_curve(CACHE_DETECT_MAX_SIZE, count, PAGES_DEFAULT,
+                                   sizes, npoints, latency_hp))
+        {
+            printf(" Failed to allocate the buffer.\n");
+            return;
+        }
+        hp_mode = PAGES_DEFAULT;
+    }
+    latency = (have_hp || !have_4k) ? latency_hp : latency_4k;
+    /* The page mode of the curve used for the cache levels */
+    mode = (have_hp || !have_4k) ? hp_mode : PAGES_4K;
 
-#ifdef __linux__
-    bi = get_asm_framebuffer_benchmarks();
-    if (bi->f && fbbuf)
+    printf(" block size : %s / 4 KiB pages\n",
+           hp_mode == PAGES_DEFAULT ? "def. pages" : "huge pages");
+    for (i = 0; i < npoints; i++)
     {
-        printf("\n");
-        printf("==========================================================================\n");
-        printf("== Framebuffer read tests.                                              ==\n");
-        printf("==                                                                      ==\n");
-        printf("== Many ARM devices use a part of the system memory as the framebuffer, ==\n");
-        printf("== typically mapped as uncached but with write-combining enabled.       ==\n");
-        printf("== Writes to such framebuffers are quite fast, but reads are much       ==\n");
-        printf("== slower and very sensitive to the alignment and the selection of      ==\n");
-        printf("== CPU instructions which are used for accessing memory.                ==\n");
-        printf("==                                                                      ==\n");
-        printf("== Many x86 systems allocate the framebuffer in the GPU memory,         ==\n");
-        printf("== accessible for the CPU via a relatively slow PCI-E bus. Moreover,    ==\n");
-        printf("== PCI-E is asymmetric and handles reads a lot worse than writes.       ==\n");
-        printf("==                                                                      ==\n");
-        printf("== If uncached framebuffer reads are reasonably fast (at least 100 MB/s ==\n");
-        printf("== or preferably >300 MB/s), then using the shadow framebuffer layer    ==\n");
-        printf("== is not necessary in Xorg DDX drivers, resulting in a nice overall    ==\n");
-        printf("== performance improvement. For example, the xf86-video-fbturbo DDX     ==\n");
-        printf("== uses this trick.                                                     ==\n");
-        printf("==========================================================================\n\n");
-
-        srcbuf = fbbuf;
-        if (bufsize > fbsize)
-            bufsize = fbsize;
-        bandwidth_bench(dstbuf, srcbuf, tmpbuf, bufsize, BLOCKSIZE, " ", bi);
+        printf(" %10s : ", format_size(buf1, sizes[i]));
+        if (have_hp || !have_4k)
+            printf("%7.1f ns", latency_hp[i]);
+        else
+            printf("%10s", "-");
+        if (have_4k)
+            printf(" / %7.1f ns\n", latency_4k[i]);
+        else
+            printf(" / %10s\n", "-");
     }
-#endif
 
-    free(poolbuf);
+    nsteps = find_curve_steps(latency, npoints, 0.10, 0.3, 3, steps, 16);
+    ncaches = read_sysfs_caches(cpu, caches, 16);
+
+    printf("\n Detected memory hierarchy (CPU %d):\n\n", cpu);
+    printf("      level :    detected size :       sysfs size :  latency\n");
+    for (i = 0; i < nsteps; i++)
+    {
+        m.best = m.median = steps[i].level;
+        m.stddev = 0;
+        if (i == nsteps - 1 && steps[i].last == npoints - 1)
+        {
+            report_add("cache detection", "memory", sizes[steps[i].last], 1,
+                       &m, "ns", mode);
+            printf(" %10s : %16s : %16s : %6.1f ns\n", "memory", "", "",
+                   steps[i].level);
+            break;
+        }
+        sprintf(buf2, "L%d", i + 1);
+        report_add("cache detection", buf2, sizes[steps[i].last], 1, &m, "ns",
+                   mode);
+        printf(" %10s : %16s : ", buf2,
+               format_size(buf1, sizes[steps[i].last]));
+        if (i < ncaches && caches[i].level == i + 1)
+            printf("%16s : ", format_size(buf1, caches[i].size));
+        else
+            printf("%16s : ", "-");
+        printf("%6.1f ns\n", steps[i].level);
+    }
+    if (nsteps > 0 && steps[nsteps - 1].last == npoints - 1 &&
+        nsteps - 1 < ncaches)
+    {
+        printf("\n Warning: fewer cache levels were detected than reported by sysfs.\n");
+    }
+
+    if (!have_hp || !have_4k)
+    {
+        if (cfg.hugepage == PAGES_4K || cfg.hugepage == PAGES_DEFAULT)
+            printf("\n Huge pages are not selected, skipping the TLB reach detection.\n");
+        else
+            printf("\n Huge pages are not available, skipping the TLB reach detection.\n");
+        return;
+    }
+
+    for (i = 0; i < npoints; i++)
+        extra[i] = latency_4k[i] > latency_hp[i] ?
+                   latency_4k[i] - latency_hp[i] : 0;
+    nsteps = find_curve_steps(extra, npoints, 0.25, 1.0, 3, steps, 16);
+
+    printf("\n TLB reach (extra latency with 4 KiB pages compared to huge pages):\n\n");
+    for (i = 0, k = -1; i < nsteps; i++)
+    {
+        /* Skip the steps, which are too small to be meaningful */
+        if (k >= 0 && fabs(steps[i].level - steps[k].level) < 1.0)
+            continue;
+        m.best = m.median = steps[i].level;
+        m.stddev = 0;
+        report_add("cache detection", "TLB miss penalty",
+                   k < 0 ? 0 : sizes[steps[i - 1].last], 1, &m, "ns", mode);
+        if (k < 0)
+            printf("   up to %10s : %+6.1f ns\n",
+                   format_size(buf1, sizes[steps[i].last]), steps[i].level);
+        else
+            printf("   above %10s : %+6.1f ns\n",
+                   format_size(buf1, sizes[steps[i - 1].last]), steps[i].level);
+        k = i;
+    }
+}
+
+static void cache_detect_tests(int count)
+{
+    int cpus[MAX_CPUS];
+
+    /*
+     * Stay on the same CPU, so that the sysfs information is relevant. The
+     * test runs in a separate thread to keep the affinity of the main one.
+     */
+    get_cpu_list(cpus, MAX_CPUS);
+    if (!run_threads(1, cpus, 1, cache_detect_thread, &count))
+        cache_detect_thread(0, cpus[0], &count);
+}
+
+#define TLB_PAGE_SIZE      4096
+#define TLB_MIN_PAGES      16
+
+/*
+ * Link the pages of the buffer into a single random cycle (Sattolo's
+ * algorithm again), touching exactly one cache line in each page. The
+ * position of the cache line within the page is a hash of the page number.
+ * With a simple pattern (like page number modulo 64) the lines would only
+ * use a small part of the cache sets if the buffer is physically contiguous
+ * (huge pages), because the higher set index bits would repeat the pattern.
+ */
+static char *page_chase_init(char *buffer, int npages, uint32_t *perm)
+{
+    int i, j;
+    uint32_t tmp;
+
+    #define PAGE_LINE(i) (buffer + (int64_t)(i) * TLB_PAGE_SIZE +          \
+                          (((uint32_t)(i) * 2654435761U) >> 26) *          \
+                          POINTER_CHASE_STRIDE)
+    for (i = 0; i < npages; i++)
+        perm[i] = i;
+    for (i = npages - 1; i > 0; i--)
+    {
+        j = rand32() % i;
+        tmp = perm[i];
+        perm[i] = perm[j];
+        perm[j] = tmp;
+    }
+    for (i = 0; i < npages; i++)
+        *(char **)PAGE_LINE(i) = PAGE_LINE(perm[i]);
+    return PAGE_LINE(0);
+    #undef PAGE_LINE
+}
+
+/*
+ * Measure the time (in nanoseconds) needed for a single hop of pointer
+ * chasing over 'npages' pages in a random order. The best result is
+ * returned, the summary of all the measurements is stored in 'm'.
+ */
+static double tlb_measure(char *buffer, int npages, int count, uint32_t *perm,
+                          measurement *m)
+{
+    static void * volatile dummy;
+    double t, t_before, t_after;
+    double xs, xs1, xs2, min_t, t_start;
+    double samples[MAX_SAMPLES];
+    char *start;
+    int n;
+
+    xs1 = xs2 = 0;
+    t_start = gettime();
+    for (n = 1; n <= cfg.maxrepeats; n++)
+    {
+        start = page_chase_init(buffer, npages, perm);
+        /* Warm up the caches and TLB */
+        dummy = pointer_chase_test(start, npages);
+
+        t_before = gettime();
+        dummy = pointer_chase_test(start, count);
+        t_after = gettime();
+        t = t_after - t_before;
+        samples[n - 1] = t * 1000000000. / count;
+
+        xs1 += t;
+        xs2 += t * t;
+
+        if (n == 1 || t < min_t)
+            min_t = t;
+
+        if (n > 2)
+        {
+            xs = sqrt((xs2 * n - xs1 * xs1) / (n * (n - 1)));
+            if (xs < min_t / 1000.)
+                break;
+        }
+        if (out_of_time(t_start))
+            break;
+    }
+    measurement_from_samples(m, samples,
+                             n > cfg.maxrepeats ? cfg.maxrepeats : n, 0);
+    return min_t * 1000000000. / count;
+}
+
+#define TLB_MAXPOINTS 64
+
+static struct
+{
+    int         mode;
+    const char *label;
+} tlb_page_modes[] =
+{
+    { PAGES_4K,  "4k" },
+    { PAGES_THP, "thp" },
+    { PAGES_2M,  "2m" },
+    { PAGES_1G,  "1g" },
+    { 0, NULL }
+};
+
+/*
+ * Measure the latency of page-stride pointer chasing over 16 up to
+ * 'maxsize' / 4 KiB pages with the buffer backed by 4 KiB pages, THP,
+ * 2 MiB and 1 GiB pages (or only by the pages selected by --hugepage).
+ */
+static void tlb_tests(int64_t maxsize, int count)
+{
+    int npages[TLB_MAXPOINTS];
+    double latency[4][TLB_MAXPOINTS];
+    int have_mode[4];
+    char *buffer, *buffer_alloc;
+    uint32_t *perm;
+    measurement m;
+    char buf[32];
+    int i, k, npoints = 0, maxpages = maxsize / TLB_PAGE_SIZE;
+    int64_t n;
+
+    for (n = TLB_MIN_PAGES; n <= maxpages; n *= 2)
+    {
+        for (k = 0; k < 2; k++)
+            if (n + n * k / 2 <= maxpages && npoints < TLB_MAXPOINTS)
+                npages[npoints++] = n + n * k / 2;
+    }
 
     printf("\n");
     printf("==========================================================================\n");
-    printf("== Memory latency test                                                  ==\n");
+    printf("== TLB miss latency test                                                ==\n");
     printf("==                                                                      ==\n");
-    printf("== Average time is measured for random memory accesses in the buffers   ==\n");
-    printf("== of different sizes. The larger is the buffer, the more significant   ==\n");
-    printf("== are relative contributions of TLB, L1/L2 cache misses and SDRAM      ==\n");
+    printf("== The pages of the buffer are linked into a random cycle, which is     ==\n");
+    printf("== walked by a chain of dependent loads touching exactly one cache line ==\n");
+    printf("== per 4 KiB page. The buffer is backed by 4 KiB pages, transparent     ==\n");
+    printf("== huge pages, 2 MiB and 1 GiB hugetlbfs pages. The steps in the 4k     ==\n");
+    printf("== column show the DTLB and STLB reach, the difference between the      ==\n");
+    printf("== columns is the cost of the TLB misses and page walks.                ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Note: The explicit 2 MiB and 1 GiB pages must be reserved in advance ==\n");
+    printf("==       (see /sys/kernel/mm/hugepages), otherwise '-' is shown.        ==\n");
+    printf("==========================================================================\n\n");
+
+    perm = (uint32_t *)malloc(maxpages * sizeof(uint32_t));
+    if (!perm)
+        return;
+
+    for (k = 0; tlb_page_modes[k].label; k++)
+    {
+        have_mode[k] = 0;
+        if (cfg.hugepage != HUGEPAGE_AUTO &&
+            cfg.hugepage != tlb_page_modes[k].mode)
+            continue;
+        buffer_alloc = alloc_latency_buffer(maxpages * (int64_t)TLB_PAGE_SIZE,
+                                            tlb_page_modes[k].mode, &buffer);
+        if (!buffer_alloc)
+            continue;
+        have_mode[k] = 1;
+        for (i = 0; i < npoints; i++)
+        {
+            latency[k][i] = tlb_measure(buffer, npages[i], count, perm, &m);
+            report_add("tlb", "page stride pointer chasing",
+                       npages[i] * (int64_t)TLB_PAGE_SIZE, 1, &m, "ns",
+                       tlb_page_modes[k].mode);
+        }
+        free_pages(buffer_alloc);
+    }
+    free(perm);
+
+    printf("    pages (   memory) :");
+    for (k = 0; tlb_page_modes[k].label; k++)
+        printf(" %10s", tlb_page_modes[k].label);
+    printf("\n");
+    for (i = 0; i < npoints; i++)
+    {
+        printf(" %8d (%9s) :", npages[i],
+               format_size(buf, npages[i] * (int64_t)TLB_PAGE_SIZE));
+        for (k = 0; tlb_page_modes[k].label; k++)
+        {
+            if (have_mode[k])
+                printf(" %7.1f ns", latency[k][i]);
+            else
+                printf(" %10s", "-");
+        }
+        printf("\n");
+    }
+}
+
+#define LOAD_CHUNK_SIZE    4096
+#define LOAD_DELAYS        10
+
+/* The delay (in loop iterations) after each chunk processed by the load */
+static const int load_delays[LOAD_DELAYS] =
+{
+    0, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000
+};
+
+typedef struct
+{
+    void          (*f)(int64_t *, int64_t *, int);
+    int             size;
+    int             delay;
+    int             probe_size;
+    int             probe_count;
+    spin_barrier_t  barrier;
+    volatile int    stop;
+    int             ok;
+    double         *speed;
+    measurement     latency;
+} loaded_latency_ctx;
+
+static void __attribute__((noinline)) delay_loop(int n)
+{
+    volatile int i;
+    for (i = 0; i < n; i++) {}
+}
+
+/*
+ * The thread 0 measures the pointer chasing latency, the other threads
+ * keep running the bandwidth kernel on their own buffers (with a delay
+ * after every chunk) until the latency measurements are done.
+ */
+static void loaded_latency_thread(int thread_index, int cpu, void *arg)
+{
+    loaded_latency_ctx *ctx = (loaded_latency_ctx *)arg;
+    int64_t *srcbuf, *dstbuf;
+    char *buffer, *buffer_alloc = NULL;
+    uint32_t *perm = NULL;
+    void *poolbuf = NULL;
+    double t1, t2, bytes = 0;
+    int j;
+
+    if (thread_index == 0)
+    {
+        perm = (uint32_t *)malloc(ctx->probe_size / POINTER_CHASE_STRIDE *
+                                  sizeof(uint32_t));
+        if (perm)
+            buffer_alloc = alloc_latency_buffer(ctx->probe_size,
+                                                buffer_page_mode(), &buffer);
+        spin_barrier_wait(&ctx->barrier);
+        if (buffer_alloc)
+        {
+            pointer_chase_measure(buffer, ctx->probe_size, ctx->probe_count,
+                                  ctx->probe_size, perm, &ctx->latency);
+            ctx->ok = 1;
+        }
+        ctx->stop = 1;
+        spin_barrier_wait(&ctx->barrier);
+        free_pages(buffer_alloc);
+        free(perm);
+        return;
+    }
+
+    poolbuf = alloc_four_nonaliased_buffers((void **)&srcbuf, ctx->size,
+                                            (void **)&dstbuf, ctx->size,
+                                            NULL, 0, NULL, 0,
+                                            buffer_page_mode());
+    spin_barrier_wait(&ctx->barrier);
+    t1 = gettime();
+    while (poolbuf && !ctx->stop)
+    {
+        for (j = 0; j < ctx->size && !ctx->stop; j += LOAD_CHUNK_SIZE)
+        {
+            ctx->f(dstbuf + j / sizeof(int64_t), srcbuf + j / sizeof(int64_t),
+                   LOAD_CHUNK_SIZE);
+            bytes += LOAD_CHUNK_SIZE;
+            delay_loop(ctx->delay);
+        }
+    }
+    t2 = gettime();
+    ctx->speed[thread_index] = bytes / (t2 - t1) / 1000000.;
+    spin_barrier_wait(&ctx->barrier);
+    free_pages(poolbuf);
+}
+
+/*
+ * Measure the pointer chasing latency on the first CPU while 'nload'
+ * threads on the next CPUs run the bandwidth kernel 'f' with the given
+ * delay. Returns the aggregate bandwidth of the load (or a negative value
+ * on failure), the latency is stored in 'latency'.
+ */
+static double loaded_latency_measure(int nload, const int *cpus, int ncpus,
+                                     void (*f)(int64_t *, int64_t *, int),
+                                     int delay, measurement *latency)
+{
+    loaded_latency_ctx ctx;
+    double speed = 0;
+    int i;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.f = f;
+    ctx.size = cfg.bufsize - cfg.bufsize % LOAD_CHUNK_SIZE;
+    ctx.delay = delay;
+    ctx.probe_size = cfg.latbench_size - cfg.latbench_size %
+                                         POINTER_CHASE_STRIDE;
+    ctx.probe_count = cfg.latbench_count;
+    ctx.speed = (double *)calloc(nload + 1, sizeof(double));
+    spin_barrier_init(&ctx.barrier, nload + 1);
+
+    if (!ctx.speed || ctx.size == 0 ||
+        !run_threads(nload + 1, cpus, ncpus, loaded_latency_thread, &ctx) ||
+        !ctx.ok)
+    {
+        free(ctx.speed);
+        return -1;
+    }
+    for (i = 1; i <= nload; i++)
+        speed += ctx.speed[i];
+    *latency = ctx.latency;
+    free(ctx.speed);
+    return speed;
+}
+
+/*
+ * Build the latency versus bandwidth curve for each selected kernel (the
+ * same selection as in the bandwidth sweep) by varying the delay of the
+ * load threads.
+ */
+static void loaded_latency_tests(int nload)
+{
+    bench_info *kernels[SWEEP_MAX_KERNELS];
+    int cpus[MAX_CPUS];
+    int ncpus = get_cpu_list(cpus, MAX_CPUS);
+    measurement m, bw;
+    double speed;
+    char name[256];
+    int i, k, nkernels = 0;
+
+    if (nload <= 0)
+        nload = ncpus > 1 ? ncpus - 1 : 1;
+
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== Loaded latency test                                                  ==\n");
+    printf("==                                                                      ==\n");
+    printf("== The pointer chasing latency is measured on the first CPU, while the  ==\n");
+    printf("== other CPUs run a bandwidth test. The load threads insert a delay     ==\n");
+    printf("== after every 4 KiB chunk, so that the injected bandwidth goes down as ==\n");
+    printf("== the delay grows. Each line shows the latency for the given aggregate ==\n");
+    printf("== bandwidth of the load, together they form the latency versus         ==\n");
+    printf("== bandwidth curve.                                                     ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Note: 1MB = 1000000 bytes                                            ==\n");
+    printf("==========================================================================\n");
+    printf("\n Using %d load thread%s on %d CPUs, %s latency buffer\n", nload,
+           nload == 1 ? "" : "s", ncpus, format_size(name, cfg.latbench_size));
+
+    nkernels = sweep_add_kernels(kernels, nkernels, c_benchmarks);
+    nkernels = sweep_add_kernels(kernels, nkernels, libc_benchmarks);
+    nkernels = sweep_add_kernels(kernels, nkernels, get_asm_benchmarks());
+    nkernels = sweep_add_kernels(kernels, nkernels, get_plugin_benchmarks());
+    if (nkernels == 0)
+    {
+        printf("\n No benchmarks match '%s'.\n", cfg.kernels);
+        return;
+    }
+
+    for (i = 0; i < nkernels; i++)
+    {
+        printf("\n %s:\n", kernels[i]->description);
+        printf("   inject delay :      load bandwidth :    latency\n");
+        /* The idle latency first, without any load */
+        if (loaded_latency_measure(0, cpus, ncpus, kernels[i]->f, 0, &m) >= 0)
+        {
+            sprintf(name, "%s, idle", kernels[i]->description);
+            report_add("loaded latency", name, cfg.latbench_size, 1, &m,
+                       "ns", buffer_page_mode());
+            printf(" %14s : %19s : %7.1f ns\n", "idle", "-", m.best);
+        }
+        for (k = 0; k < LOAD_DELAYS; k++)
+        {
+            speed = loaded_latency_measure(nload, cpus, ncpus, kernels[i]->f,
+                                           load_delays[k], &m);
+            if (speed < 0)
+            {
+                printf(" %14d : failed to run\n", load_delays[k]);
+                continue;
+            }
+            sprintf(name, "%s, delay %d", kernels[i]->description,
+                    load_delays[k]);
+            report_add("loaded latency", name, cfg.latbench_size, nload + 1,
+                       &m, "ns", buffer_page_mode());
+            bw.best = bw.median = speed;
+            bw.stddev = 0;
+            report_add("loaded latency", name, cfg.bufsize, nload, &bw,
+                       "MB/s", buffer_page_mode());
+            printf(" %14d : %14.1f MB/s : %7.1f ns\n", load_delays[k], speed,
+                   m.best);
+            fflush(stdout);
+        }
+    }
+}
+
+#define C2C_ROUNDS 10000
+
+typedef struct
+{
+    /* The cache line bouncing between the two CPUs */
+    volatile int    flag __attribute__((aligned(128)));
+    char            padding[128 - sizeof(int)];
+    spin_barrier_t  barrier;
+    int             ok;
+    int             stop;
+    double          samples[MAX_SAMPLES];
+    int             nsamples;
+} c2c_ctx;
+
+/*
+ * The thread 0 writes the odd values and waits for the even ones, the
+ * thread 1 does the opposite. So every round moves the cache line to the
+ * other CPU and back, the thread 0 measures the time of the whole rounds.
+ */
+static void c2c_thread(int thread_index, int cpu, void *arg)
+{
+    c2c_ctx *ctx = (c2c_ctx *)arg;
+    double t1, t2, t_start = gettime();
+    int n, k, v;
+
+    for (n = 0; n < cfg.maxrepeats; n++)
+    {
+        if (thread_index == 0)
+            __atomic_store_n(&ctx->flag, 0, __ATOMIC_RELEASE);
+        spin_barrier_wait(&ctx->barrier);
+        t1 = gettime();
+        for (k = 0; k < C2C_ROUNDS; k++)
+        {
+            v = 2 * k + thread_index;
+            while (__atomic_load_n(&ctx->flag, __ATOMIC_ACQUIRE) != v) {}
+            __atomic_store_n(&ctx->flag, v + 1, __ATOMIC_RELEASE);
+        }
+        t2 = gettime();
+        if (thread_index == 0)
+        {
+            ctx->samples[n] = (t2 - t1) * 1000000000. / C2C_ROUNDS;
+            ctx->nsamples = n + 1;
+            ctx->ok = 1;
+        }
+        /* Both threads must agree on whether to continue */
+        if (thread_index == 0 && out_of_time(t_start))
+            ctx->stop = 1;
+        spin_barrier_wait(&ctx->barrier);
+        if (ctx->stop)
+            break;
+    }
+}
+
+/*
+ * Measure the round-trip time (in nanoseconds) of a cache line between
+ * two CPUs. Returns 0 on failure.
+ */
+static int c2c_measure(int cpu1, int cpu2, measurement *m)
+{
+    c2c_ctx *ctx;
+    int cpus[2];
+    int ok;
+
+    /* Not on the stack, the page alignment also covers the flag alignment */
+    if (!(ctx = (c2c_ctx *)alloc_pages(sizeof(c2c_ctx), PAGES_DEFAULT)))
+        return 0;
+    memset(ctx, 0, sizeof(c2c_ctx));
+    spin_barrier_init(&ctx->barrier, 2);
+    cpus[0] = cpu1;
+    cpus[1] = cpu2;
+    ok = run_threads(2, cpus, 2, c2c_thread, ctx) && ctx->ok;
+    if (ok)
+        measurement_from_samples(m, ctx->samples, ctx->nsamples, 0);
+    free_pages(ctx);
+    return ok;
+}
+
+/*
+ * Measure the cache line round-trip time for every pair of the CPUs and
+ * show it as a matrix. The matrix is symmetric, so only one direction is
+ * measured for each pair.
+ */
+static void c2c_tests(void)
+{
+    int cpus[MAX_CPUS];
+    int ncpus = get_cpu_list(cpus, MAX_CPUS);
+    measurement *results, m;
+    int i, j, *ok;
+
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== Core-to-core cache line transfer latency                             ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Two threads, bound to a pair of CPUs, take turns in incrementing a   ==\n");
+    printf("== shared counter (an atomic load waits for the other CPU's value, an   ==\n");
+    printf("== atomic store passes the turn back). The numbers show the round-trip  ==\n");
+    printf("== time of the cache line between the CPUs, which reveals the SMT       ==\n");
+    printf("== siblings, the groups of cores sharing a cache and the sockets.       ==\n");
+    printf("==========================================================================\n\n");
+
+    if (ncpus < 2)
+    {
+        printf(" At least 2 CPUs are needed for this test.\n");
+        return;
+    }
+
+    results = (measurement *)calloc(ncpus * ncpus, sizeof(measurement));
+    ok = (int *)calloc(ncpus * ncpus, sizeof(int));
+    if (!results || !ok)
+    {
+        free(results);
+        free(ok);
+        return;
+    }
+
+    printf(" Round-trip latency (ns):\n\n");
+    printf(" CPU :");
+    for (j = 0; j < ncpus; j++)
+        printf(" %6d", cpus[j]);
+    printf("\n");
+    for (i = 0; i < ncpus; i++)
+    {
+        printf(" %3d :", cpus[i]);
+        for (j = 0; j < ncpus; j++)
+        {
+            if (i == j)
+            {
+                printf(" %6s", "-");
+                continue;
+            }
+            /* The matrix is symmetric, each pair is measured only once */
+            if (j > i)
+            {
+                ok[i * ncpus + j] = ok[j * ncpus + i] =
+                    c2c_measure(cpus[i], cpus[j], &m);
+                results[i * ncpus + j] = results[j * ncpus + i] = m;
+                if (ok[i * ncpus + j])
+                    report_add_cpu_pair("core to core latency", "round trip",
+                                        cpus[i], cpus[j], &m, "ns");
+            }
+            if (!ok[i * ncpus + j])
+            {
+                printf(" %6s", "n/a");
+                continue;
+            }
+            printf(" %6.1f", results[i * ncpus + j].best);
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+
+    free(results);
+    free(ok);
+}
+
+typedef struct
+{
+    int    size;
+    int    count;
+    int    mem_node;
+    int    ok;
+    measurement latency;
+} numa_latency_ctx;
+
+static void numa_latency_thread(int thread_index, int cpu, void *arg)
+{
+    numa_latency_ctx *ctx = (numa_latency_ctx *)arg;
+    double t_noaccess, t_noaccess2;
+    measurement latency2;
+    char *buffer, *buffer_alloc;
+    int nbits;
+
+    if (ctx->mem_node >= 0 && !numa_bind_memory(ctx->mem_node))
+        return;
+
+    buffer_alloc = alloc_latency_buffer(ctx->size, buffer_page_mode(), &buffer);
+    if (buffer_alloc)
+    {
+        /* Make sure that the memory policy was really applied */
+        if (ctx->mem_node >= 0 && numa_node_of_address(buffer) >= 0 &&
+            numa_node_of_address(buffer) != ctx->mem_node)
+        {
+            free_pages(buffer_alloc);
+            numa_bind_memory(-1);
+            return;
+        }
+
+        for (nbits = 10; (2 << nbits) <= ctx->size; nbits++) {}
+
+        latency_bench_noaccess(buffer, ctx->count, &t_noaccess, &t_noaccess2);
+        latency_bench_measure(buffer, ctx->size, ctx->count, nbits,
+                              t_noaccess, t_noaccess2,
+                              &ctx->latency, &latency2);
+        ctx->ok = 1;
+        free_pages(buffer_alloc);
+    }
+
+    if (ctx->mem_node >= 0)
+        numa_bind_memory(-1);
+}
+
+static void print_numa_matrix_header(numa_node_info *nodes, int nnodes)
+{
+    int j;
+    printf(" CPU node \\ memory node :");
+    for (j = 0; j < nnodes; j++)
+        if (nodes[j].has_memory)
+            printf(" %8d", nodes[j].id);
+    printf("\n");
+}
+
+/*
+ * Measure the latency and bandwidth for every combination of the NUMA node
+ * which runs the code and the NUMA node which provides memory.
+ */
+static void numa_tests(int latbench_size, int latbench_count)
+{
+    int cpus[MAX_CPUS];
+    int ncpus = get_cpu_list(cpus, MAX_CPUS);
+    numa_node_info *nodes;
+    numa_latency_ctx lctx;
+    double speed, minspeed, maxspeed;
+    measurement m;
+    char name[64], buf1[32];
+    int i, j, nnodes, bind, alloc_failed = 0;
+
+    nodes = (numa_node_info *)malloc(MAX_NUMA_NODES * sizeof(numa_node_info));
+    if (!nodes)
+        return;
+    nnodes = numa_get_nodes(nodes, MAX_NUMA_NODES, cpus, ncpus);
+
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== NUMA tests                                                           ==\n");
+    printf("==                                                                      ==\n");
+    printf("== The code is run on the CPUs from one NUMA node, while the memory     ==\n");
+    printf("== buffers are allocated in another one (or the same) NUMA node. The    ==\n");
+    printf("== latency test uses a single thread on the first CPU of the node, the  ==\n");
+    printf("== bandwidth test uses all the CPUs of the node simultaneously.         ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Note 1: 1MB = 1000000 bytes                                          ==\n");
+    printf("== Note 2: The latency numbers are the extra time needed for a random   ==\n");
+    printf("==         read in the buffer on top of L1 cache latency                ==\n");
+    printf("==========================================================================\n\n");
+
+    for (i = 0; i < nnodes; i++)
+        printf(" node %d: %d CPUs%s\n", nodes[i].id, nodes[i].ncpus,
+               nodes[i].has_memory ? ", has memory" : "");
+
+    /* There is nothing to bind on a single node system */
+    bind = nnodes > 1;
+    if (bind)
+    {
+        if (!numa_bind_memory(nodes[0].id) || !numa_bind_memory(-1))
+        {
+            printf("\n Failed to set the NUMA memory policy, can't run the tests.\n");
+            free(nodes);
+            return;
+        }
+    }
+
+    printf("\n Random read latency in a %s buffer (ns):\n\n",
+           format_size(buf1, latbench_size));
+    print_numa_matrix_header(nodes, nnodes);
+    for (i = 0; i < nnodes; i++)
+    {
+        if (nodes[i].ncpus == 0)
+            continue;
+        printf(" %22d :", nodes[i].id);
+        for (j = 0; j < nnodes; j++)
+        {
+            if (!nodes[j].has_memory)
+                continue;
+            memset(&lctx, 0, sizeof(lctx));
+            lctx.size = latbench_size;
+            lctx.count = latbench_count;
+            lctx.mem_node = bind ? nodes[j].id : -1;
+            if (run_threads(1, nodes[i].cpus, 1, numa_latency_thread, &lctx) &&
+                lctx.ok)
+            {
+                sprintf(name, "cpu node %d, memory node %d", nodes[i].id,
+                        nodes[j].id);
+                report_add("numa latency", name, latbench_size, 1,
+                           &lctx.latency, "ns", buffer_page_mode());
+                printf(" %8.1f", lctx.latency.best);
+            }
+            else
+                printf(" %8s", "n/a");
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+
+    printf("\n %s bandwidth using all the CPUs of the node (MB/s):\n\n",
+           libc_benchmarks[0].description);
+    print_numa_matrix_header(nodes, nnodes);
+    for (i = 0; i < nnodes; i++)
+    {
+        if (nodes[i].ncpus == 0)
+            continue;
+        printf(" %22d :", nodes[i].id);
+        for (j = 0; j < nnodes; j++)
+        {
+            if (!nodes[j].has_memory)
+                continue;
+            speed = mt_bandwidth_measure(nodes[i].ncpus, nodes[i].cpus,
+                                         nodes[i].ncpus,
+                                         bind ? nodes[j].id : -1,
+                                         cfg.bufsize, cfg.blocksize,
+                                         libc_benchmarks[0].use_tmpbuf,
+                                         libc_benchmarks[0].f,
+                                         &minspeed, &maxspeed, &m);
+            if (speed >= 0)
+            {
+                sprintf(name, "cpu node %d, memory node %d", nodes[i].id,
+                        nodes[j].id);
+                report_add("numa bandwidth", name, cfg.bufsize, nodes[i].ncpus, &m,
+                           "MB/s", buffer_page_mode());
+                printf(" %8.1f", speed);
+            }
+            else
+                printf(" %8s", "n/a");
+            if (speed == -2)
+                alloc_failed = 1;
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    if (alloc_failed)
+        printf("\n Failed to allocate the buffers in the selected huge pages mode.\n");
+
+    free(nodes);
+}
+
+enum
+{
+    TEST_BANDWIDTH       = 1 << 0,
+    TEST_FRAMEBUFFER     = 1 << 1,
+    TEST_LATENCY         = 1 << 2,
+    TEST_THREADS         = 1 << 3,
+    TEST_NUMA            = 1 << 4,
+    TEST_POINTER_CHASING = 1 << 5,
+    TEST_MLP             = 1 << 6,
+    TEST_DETECT_CACHES   = 1 << 7,
+    TEST_SWEEP           = 1 << 8,
+    TEST_TLB             = 1 << 9,
+    TEST_LOADED_LATENCY  = 1 << 10,
+    TEST_CORE_TO_CORE    = 1 << 11,
+    TEST_ATOMICS         = 1 << 12,
+    TEST_STREAM          = 1 << 13,
+    TEST_STRIDED         = 1 << 14,
+    TEST_PREFETCH        = 1 << 15,
+    TEST_MISALIGNED      = 1 << 16,
+    TEST_SMALL_COPY      = 1 << 17,
+    TEST_DEFAULT         = TEST_BANDWIDTH | TEST_FRAMEBUFFER | TEST_LATENCY
+};
+
+static struct
+{
+    const char *name;
+    int         flag;
+} test_groups[] =
+{
+    { "bandwidth",       TEST_BANDWIDTH },
+    { "framebuffer",     TEST_FRAMEBUFFER },
+    { "latency",         TEST_LATENCY },
+    { "threads",         TEST_THREADS },
+    { "numa",            TEST_NUMA },
+    { "pointer-chasing", TEST_POINTER_CHASING },
+    { "mlp",             TEST_MLP },
+    { "detect-caches",   TEST_DETECT_CACHES },
+    { "sweep",           TEST_SWEEP },
+    { "tlb",             TEST_TLB },
+    { "loaded-latency",  TEST_LOADED_LATENCY },
+    { "core-to-core",    TEST_CORE_TO_CORE },
+    { "atomics",         TEST_ATOMICS },
+    { "stream",          TEST_STREAM },
+    { "strided",         TEST_STRIDED },
+    { "prefetch",        TEST_PREFETCH },
+    { "misaligned",      TEST_MISALIGNED },
+    { "small-copy",      TEST_SMALL_COPY },
+    { NULL, 0 }
+};
+
+/*
+ * Parse a comma separated list of the test group names or glob patterns.
+ * Returns 0 if some entry doesn't match anything.
+ */
+static int parse_test_groups(const char *list, int *tests)
+{
+    char pattern[256];
+    const char *end;
+    int i, found;
+
+    while (*list)
+    {
+        end = strchr(list, ',');
+        if (!end)
+            end = list + strlen(list);
+        if (end - list >= (int)sizeof(pattern))
+            return 0;
+        memcpy(pattern, list, end - list);
+        pattern[end - list] = 0;
+        for (i = 0, found = 0; test_groups[i].name; i++)
+        {
+            if (glob_match(pattern, test_groups[i].name))
+            {
+                *tests |= test_groups[i].flag;
+                found = 1;
+            }
+        }
+        if (!found)
+            return 0;
+        list = *end ? end + 1 : end;
+    }
+    return 1;
+}
+
+static void print_usage(const char *progname)
+{
+    printf("Usage: %s [options]\n", progname);
+    printf("\n");
+    printf("Test selection:\n");
+    printf("  --tests=LIST comma separated list of the test groups to run (glob\n");
+    printf("               patterns are accepted): bandwidth, framebuffer, latency,\n");
+    printf("               threads, numa, pointer-chasing, mlp, detect-caches,\n");
+    printf("               sweep, tlb, loaded-latency, core-to-core, atomics,\n");
+    printf("               stream, strided, prefetch, misaligned and small-copy.\n");
+    printf("               The default is bandwidth,framebuffer,latency\n");
+    printf("  --kernels=LIST\n");
+    printf("               run only the bandwidth benchmarks with the description\n");
+    printf("               matching one of the comma separated glob patterns, for\n");
+    printf("               example --kernels='*memcpy*,SSE2 copy*'\n");
+    printf("  --list       list the available bandwidth benchmarks\n");
+    printf("  --plugin=PATH:SYMBOL[,SYMBOL...]\n");
+    printf("               load the shared library and add its functions to the\n");
+    printf("               bandwidth benchmarks. SYMBOL is a function with the\n");
+    printf("               kernel signature f(int64_t *, int64_t *, int) or\n");
+    printf("               memcpy=NAME or memset=NAME for the functions with the\n");
+    printf("               standard signatures. Can be used more than once\n");
+    printf("  --threads=N  run the bandwidth tests on 1, 2, 4, ... N threads\n");
+    printf("               simultaneously (N=0 means all available CPUs)\n");
+    printf("  --numa       run the NUMA node-to-node latency and bandwidth tests\n");
+    printf("  --stream     run the STREAM copy, scale, add and triad kernels\n");
+    printf("  --sweep      run the bandwidth tests on the working sets from 4 KiB\n");
+    printf("               up to --sweep-max (memcpy, memset and C read unless\n");
+    printf("               selected by --kernels)\n");
+    printf("  --mlp        run the memory-level parallelism test (1..32 chains)\n");
+    printf("  --strided    read one element every 8 bytes .. 64 KiB\n");
+    printf("  --stride-write\n");
+    printf("               also run the strided test with writes\n");
+    printf("  --prefetch-tuning\n");
+    printf("               find the best prefetch distance and hint for the C read\n");
+    printf("               and copy kernels on the buffer sizes up to --size\n");
+    printf("  --misaligned run memcpy, MOVSB and the unaligned SIMD copy with the\n");
+    printf("               source and destination offset by 0..63 bytes\n");
+    printf("  --small-copy measure the time per call of memcpy, memset, MOVSB and\n");
+    printf("               the copy kernels for the sizes from 1 byte to 8 KiB\n");
+    printf("  --detect-caches\n");
+    printf("               detect the cache sizes, latencies and TLB reach from\n");
+    printf("               the pointer chasing latency curve\n");
+    printf("  --tlb        run the TLB miss latency test (one cache line per page)\n");
+    printf("               with 4k, thp, 2m and 1g pages, up to --tlb-max\n");
+    printf("  --loaded-latency\n");
+    printf("               measure the pointer chasing latency on one CPU while\n");
+    printf("               the other CPUs run a bandwidth test (memcpy, memset and\n");
+    printf("               C read unless selected by --kernels) with different\n");
+    printf("               delays, to get the latency versus bandwidth curve\n");
+    printf("  --load-threads=N\n");
+    printf("               number of the load threads for --loaded-latency\n");
+    printf("               (default: all the CPUs except the first one)\n");
+    printf("  --core-to-core\n");
+    printf("               measure the cache line round-trip time between every\n");
+    printf("               pair of CPUs\n");
+    printf("  --atomics    measure the throughput of the contended atomic operations\n");
+    printf("               on 1, 2, 4, ... threads (up to all the CPUs or --threads)\n");
+    printf("  --pointer-chasing\n");
+    printf("               run the latency test, which walks a random cycle of\n");
+    printf("               dependent loads instead of generating random addresses\n");
+    printf("\n");
+    printf("Test parameters (sizes accept K, M and G suffixes):\n");
+    printf("  --size=SIZE  buffer size for the bandwidth tests (default %dM)\n",
+           SIZE / (1024 * 1024));
+    printf("  --blocksize=SIZE\n");
+    printf("               temporary buffer size for 2-pass copy (default %d)\n",
+           BLOCKSIZE);
+    printf("  --latency-size=SIZE\n");
+    printf("               buffer size for the latency tests (default %dM)\n",
+           SIZE * 2 / (1024 * 1024));
+    printf("  --latency-count=N\n");
+    printf("               number of accesses per latency measurement\n");
+    printf("               (default %d)\n", LATBENCH_COUNT);
+    printf("  --sweep-max=SIZE\n");
+    printf("               the largest working set size for --sweep (default 1G)\n");
+    printf("  --tlb-max=SIZE\n");
+    printf("               the largest buffer size for --tlb (default 1G)\n");
+    printf("  --stride-size=SIZE\n");
+    printf("               buffer size for --strided (default: the same as --size)\n");
+    printf("  --align-size=SIZE\n");
+    printf("               copy size for --misaligned (default 64K)\n");
+    printf("  --align-step=N\n");
+    printf("               step of the offsets for --misaligned (default 8)\n");
+    printf("  --size-distribution=FILE\n");
+    printf("               recorded copy sizes for --small-copy (one per line)\n");
+    printf("  --repeats=N  the largest number of measurements per test, fewer are\n");
+    printf("               done if the results are stable (default %d)\n",
+           MAXREPEATS);
+    printf("  --budget=SECONDS\n");
+    printf("               time limit for the measurements of one test\n");
+    printf("  --sample-time=SECONDS\n");
+    printf("               duration of one bandwidth measurement (default 0.5),\n");
+    printf("               can be much shorter with a high resolution timer\n");
+    printf("  --timer=NAME time source: monotonic (default), tsc (x86 invariant\n");
+    printf("               TSC, calibrated against the monotonic clock) or\n");
+    printf("               gettimeofday\n");
+    printf("  --perf       collect the hardware performance counters (cycles,\n");
+    printf("               instructions, LLC and dTLB misses, ...) via\n");
+    printf("               perf_event_open and show them per byte or per access\n");
+    printf("               for the single-threaded bandwidth and latency tests\n");
+    printf("  --hugepage=MODE\n");
+    printf("               pages backing all the buffers: 4k (MADV_NOHUGEPAGE),\n");
+    printf("               thp (MADV_HUGEPAGE), 2m or 1g (MAP_HUGETLB, needs\n");
+    printf("               reserved huge pages), default, on (same as thp), off\n");
+    printf("               (same as 4k) or auto (the default pages, but the\n");
+    printf("               latency tests are run both with 4k and thp)\n");
+    printf("\n");
+    printf("Output:\n");
+    printf("  --format=FORMAT\n");
+    printf("               emit every measurement as a record in the given format\n");
+    printf("               (text, json or csv), the default is text\n");
+    printf("  --output=FILE\n");
+    printf("               write the json or csv records to FILE and keep the\n");
+    printf("               human-readable report on stdout\n");
+    printf("  --compare=FILE\n");
+    printf("               compare the results with the baseline saved earlier by\n");
+    printf("               --format=csv and exit with the status 2 if there are\n");
+    printf("               regressions\n");
+    printf("  --threshold=PERCENT\n");
+    printf("               the smallest difference from the baseline, which is\n");
+    printf("               treated as a regression (default 5), if it is also\n");
+    printf("               larger than twice the standard deviation\n");
+    printf("  --help       show this help\n");
+}
+
+static void print_benchmark_list(const char *title, bench_info *bi)
+{
+    if (!bi->f)
+        return;
+    printf("%s:\n", title);
+    for (; bi->f; bi++)
+        printf("  %s\n", bi->description);
+}
+
+static int count_selected_kernels(bench_info *bi)
+{
+    int n = 0;
+    for (; bi->f; bi++)
+        n += kernel_selected(bi->description);
+    return n;
+}
+
+static void mt_bandwidth_tests(int maxthreads)
+{
+    int cpus[MAX_CPUS];
+    int ncpus = get_cpu_list(cpus, MAX_CPUS);
+    bench_info *groups[4];
+    int i, n;
+
+    if (maxthreads <= 0)
+        maxthreads = ncpus;
+
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== Multi-threaded memory bandwidth tests                                ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Each test is run on 1, 2, 4, ... threads simultaneously. Every       ==\n");
+    printf("== thread is bound to its own CPU and uses its own buffers.             ==\n");
+    printf("== The aggregate bandwidth of all the threads is shown together with    ==\n");
+    printf("== the average, minimal and maximal bandwidth of a single thread.       ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Note 1: 1MB = 1000000 bytes                                          ==\n");
+    printf("== Note 2: Results for 'copy' tests show how many bytes can be          ==\n");
+    printf("==         copied per second                                            ==\n");
+    printf("==========================================================================\n\n");
+    printf(" Using up to %d threads on %d CPUs\n\n", maxthreads, ncpus);
+
+    groups[0] = c_benchmarks;
+    groups[1] = libc_benchmarks;
+    groups[2] = get_asm_benchmarks();
+    groups[3] = get_plugin_benchmarks();
+    for (i = 0, n = 0; i < 4; i++)
+    {
+        if (!count_selected_kernels(groups[i]))
+            continue;
+        if (n++)
+            printf(" ---\n");
+        mt_bandwidth_bench(maxthreads, cpus, ncpus, cfg.bufsize,
+                           cfg.blocksize, " ", groups[i]);
+    }
+}
+
+static void atomic_tests(int maxthreads)
+{
+    int cpus[MAX_CPUS];
+    int ncpus = get_cpu_list(cpus, MAX_CPUS);
+
+    if (maxthreads <= 0)
+        maxthreads = ncpus;
+
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== Contended atomic operations                                          ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Every thread keeps doing atomic fetch-add (lock xadd on x86), CAS    ==\n");
+    printf("== loop increments or plain stores on its counter. The counter is       ==\n");
+    printf("== either shared by all the threads (same line), or adjacent to the     ==\n");
+    printf("== other threads' counters (false sharing), or on its own cache line    ==\n");
+    printf("== (padded). The total number of operations per second is shown for     ==\n");
+    printf("== 1, 2, 4, ... threads together with the slowest and the fastest       ==\n");
+    printf("== thread and the fairness (Jain's index, 1.0 is perfectly fair).       ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Note: 1 Mops/s = 1000000 operations per second                       ==\n");
+    printf("==========================================================================\n\n");
+    printf(" Using up to %d threads on %d CPUs\n\n", maxthreads, ncpus);
+
+    atomic_bench(maxthreads, cpus, ncpus, " ");
+}
+
+static stream_info c_stream_benchmarks[] =
+{
+    { "C STREAM copy", STREAM_COPY, stream_copy },
+    { "C STREAM scale", STREAM_SCALE, stream_scale },
+    { "C STREAM add", STREAM_ADD, stream_add },
+    { "C STREAM triad", STREAM_TRIAD, stream_triad },
+    { NULL, 0, NULL }
+};
+
+/* The number of arrays accessed by each STREAM kernel */
+static const int stream_arrays[] = { 2, 2, 3, 3 };
+
+static void stream_init(double *a, double *b, double *c, int size)
+{
+    int i, n = size / sizeof(double);
+    for (i = 0; i < n; i++)
+    {
+        a[i] = 1.0;
+        b[i] = 2.0;
+        c[i] = 0.0;
+    }
+}
+
+/*
+ * Run the STREAM kernel 'f' on the arrays in the same order as STREAM does
+ * (c = a, b = s * c, c = a + b, a = b + s * c) and return the best bandwidth
+ * in the tinymembench byte accounting (the size of the destination array
+ * per second, like for the copy tests).
+ */
+static double stream_measure(double *a, double *b, double *c, int size,
+                             stream_info *si, measurement *m)
+{
+    int i, n, loopcount, innerloopcount;
+    double *dst, *src1, *src2;
+    double t1, t2;
+    double speed, maxspeed;
+    double s, s0, s1, s2, t_start;
+    double samples[MAX_SAMPLES];
+
+    switch (si->op)
+    {
+    case STREAM_COPY:
+        dst = c, src1 = a, src2 = b;
+        break;
+    case STREAM_SCALE:
+        dst = b, src1 = c, src2 = a;
+        break;
+    case STREAM_ADD:
+        dst = c, src1 = a, src2 = b;
+        break;
+    default:
+        dst = a, src1 = b, src2 = c;
+        break;
+    }
+
+    stream_init(a, b, c, size);
+    s = s0 = s1 = s2 = 0;
+    maxspeed   = 0;
+    perf_reset();
+    t_start = gettime();
+    for (n = 0; n < cfg.maxrepeats; n++)
+    {
+        si->f(dst, src1, src2, size);
+        loopcount = 0;
+        innerloopcount = 1;
+        perf_start();
+        t1 = gettime();
+        do
+        {
+            loopcount += innerloopcount;
+            for (i = 0; i < innerloopcount; i++)
+                si->f(dst, src1, src2, size);
+            innerloopcount *= 2;
+            t2 = gettime();
+        } while (t2 - t1 < cfg.sample_time);
+        perf_stop((double)size * loopcount);
+        speed = (double)size * loopcount / (t2 - t1) / 1000000.;
+        samples[n] = speed;
+
+        s0 += 1;
+        s1 += speed;
+        s2 += speed * speed;
+
+        if (speed > maxspeed)
+            maxspeed = speed;
+
+        if (s0 > 2)
+        {
+            s = sqrt((s0 * s2 - s1 * s1) / (s0 * (s0 - 1)));
+            if (s < maxspeed / 1000.)
+                break;
+        }
+        if (out_of_time(t_start))
+            break;
+    }
+
+    measurement_from_samples(m, samples, s0, 1);
+    return maxspeed;
+}
+
+static void stream_bench(double *a, double *b, double *c, int size,
+                         const char *indent_prefix, stream_info *si)
+{
+    double speed;
+    measurement m;
+    int k;
+
+    for (; si->f; si++)
+    {
+        if (!kernel_selected(si->description))
+            continue;
+        speed = stream_measure(a, b, c, size, si, &m);
+        report_add("stream", si->description, size, 1, &m, "MB/s",
+                   buffer_page_mode());
+        printf("%s%-36s : %8.1f MB/s (STREAM: %8.1f MB/s)",
+               indent_prefix, si->description, speed,
+               speed * stream_arrays[si->op]);
+        if (speed > 0 && m.stddev / speed * 100. >= 0.1)
+            printf(" (%.1f%%)", m.stddev / speed * 100.);
+        printf("\n");
+        perf_print("     ", "B");
+        perf_report("stream", si->description, size, "B",
+                    buffer_page_mode());
+
+        k = stream_arrays[si->op];
+        m.best *= k;
+        m.median *= k;
+        m.stddev *= k;
+        report_add("stream", si->description, size, 1, &m, "STREAM MB/s",
+                   buffer_page_mode());
+    }
+}
+
+static void stream_tests(void)
+{
+    double *a, *b, *c;
+    void *poolbuf;
+    stream_info *groups[2], *si;
+    int i, n, selected, size = cfg.bufsize - cfg.bufsize % 64;
+
+    poolbuf = alloc_four_nonaliased_buffers((void **)&a, size,
+                                            (void **)&b, size,
+                                            (void **)&c, size,
+                                            NULL, 0,
+                                            buffer_page_mode());
+    if (!poolbuf)
+    {
+        printf("\nFailed to allocate the buffers for the STREAM tests\n");
+        return;
+    }
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== STREAM tests                                                         ==\n");
+    printf("==                                                                      ==\n");
+    printf("== The STREAM kernels on three arrays of doubles, each of --size bytes: ==\n");
+    printf("==   copy:  c = a            scale: b = 3.0 * c                         ==\n");
+    printf("==   add:   c = a + b        triad: a = b + 3.0 * c                     ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Note 1: 1MB = 1000000 bytes                                          ==\n");
+    printf("== Note 2: The first number counts the bytes written to the destination ==\n");
+    printf("==         array (as for the 'copy' tests), the STREAM number counts    ==\n");
+    printf("==         all the read and written bytes (2 arrays for copy and scale, ==\n");
+    printf("==         3 arrays for add and triad), as the STREAM benchmark does    ==\n");
+    printf("== Note 3: If sample standard deviation exceeds 0.1%%, it is shown in    ==\n");
+    printf("==         brackets                                                     ==\n");
+    printf("==========================================================================\n\n");
+
+    groups[0] = c_stream_benchmarks;
+    groups[1] = get_asm_stream_benchmarks();
+    for (i = 0, n = 0; i < 2; i++)
+    {
+        selected = 0;
+        for (si = groups[i]; si->f; si++)
+            selected += kernel_selected(si->description);
+        if (!selected)
+            continue;
+        if (n++)
+            printf(" ---\n");
+        stream_bench(a, b, c, size, " ", groups[i]);
+    }
+
+    free_pages(poolbuf);
+}
+
+static void bandwidth_tests(void)
+{
+    int64_t *srcbuf, *dstbuf, *tmpbuf;
+    void *poolbuf;
+    bench_info *groups[4];
+    int i, n;
+
+    poolbuf = alloc_four_nonaliased_buffers((void **)&srcbuf, cfg.bufsize,
+                                            (void **)&dstbuf, cfg.bufsize,
+                                            (void **)&tmpbuf, cfg.blocksize,
+                                            NULL, 0,
+                                            buffer_page_mode());
+    if (!poolbuf)
+    {
+        printf("\nFailed to allocate the buffers for the bandwidth tests\n");
+        return;
+    }
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== Memory bandwidth tests                                               ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Note 1: 1MB = 1000000 bytes                                          ==\n");
+    printf("== Note 2: Results for 'copy' tests show how many bytes can be          ==\n");
+    printf("==         copied per second (adding together read and writen           ==\n");
+    printf("==         bytes would have provided twice higher numbers)              ==\n");
+    printf("== Note 3: 2-pass copy means that we are using a small temporary buffer ==\n");
+    printf("==         to first fetch data into it, and only then write it to the   ==\n");
+    printf("==         destination (source -> L1 cache, L1 cache -> destination)    ==\n");
+    printf("== Note 4: If sample standard deviation exceeds 0.1%%, it is shown in    ==\n");
+    printf("==         brackets                                                     ==\n");
+    printf("== Note 5: Results for 'read:write' tests include both read and written ==\n");
+    printf("==         bytes (R:W is the ratio of the read and written cache lines) ==\n");
+    printf("==========================================================================\n\n");
+    groups[0] = c_benchmarks;
+    groups[1] = libc_benchmarks;
+    groups[2] = get_asm_benchmarks();
+    groups[3] = get_plugin_benchmarks();
+    for (i = 0, n = 0; i < 4; i++)
+    {
+        if (!count_selected_kernels(groups[i]))
+            continue;
+        if (n++)
+            printf(" ---\n");
+        bandwidth_bench(dstbuf, srcbuf, tmpbuf, cfg.bufsize, cfg.blocksize,
+                        " ", groups[i], "bandwidth");
+    }
+
+    free_pages(poolbuf);
+}
+
+static void framebuffer_tests(void)
+{
+#ifdef __linux__
+    int64_t *dstbuf, *tmpbuf, *fbbuf;
+    void *poolbuf;
+    size_t fbsize = 0;
+    int bufsize = cfg.bufsize;
+    bench_info *bi = get_asm_framebuffer_benchmarks();
+
+    if (!bi->f)
+        return;
+    fbbuf = mmap_framebuffer(&fbsize);
+    fbsize = (fbsize / cfg.blocksize) * cfg.blocksize;
+    if (!fbbuf || fbsize == 0)
+        return;
+    if (bufsize > fbsize)
+        bufsize = fbsize;
+
+    poolbuf = alloc_four_nonaliased_buffers((void **)&dstbuf, bufsize,
+                                            (void **)&tmpbuf, cfg.blocksize,
+                                            NULL, 0, NULL, 0,
+                                            buffer_page_mode());
+    if (!poolbuf)
+        return;
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== Framebuffer read tests.                                              ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Many ARM devices use a part of the system memory as the framebuffer, ==\n");
+    printf("== typically mapped as uncached but with write-combining enabled.       ==\n");
+    printf("== Writes to such framebuffers are quite fast, but reads are much       ==\n");
+    printf("== slower and very sensitive to the alignment and the selection of      ==\n");
+    printf("== CPU instructions which are used for accessing memory.                ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Many x86 systems allocate the framebuffer in the GPU memory,         ==\n");
+    printf("== accessible for the CPU via a relatively slow PCI-E bus. Moreover,    ==\n");
+    printf("== PCI-E is asymmetric and handles reads a lot worse than writes.       ==\n");
+    printf("==                                                                      ==\n");
+    printf("== If uncached framebuffer reads are reasonably fast (at least 100 MB/s ==\n");
+    printf("== or preferably >300 MB/s), then using the shadow framebuffer layer    ==\n");
+    printf("== is not necessary in Xorg DDX drivers, resulting in a nice overall    ==\n");
+    printf("== performance improvement. For example, the xf86-video-fbturbo DDX     ==\n");
+    printf("== uses this trick.                                                     ==\n");
+    printf("==========================================================================\n\n");
+    bandwidth_bench(dstbuf, fbbuf, tmpbuf, bufsize, cfg.blocksize, " ", bi,
+                    "framebuffer bandwidth");
+    free_pages(poolbuf);
+#endif
+}
+
+/*
+ * Run one of the latency benchmarks in the huge pages mode selected by
+ * --hugepage. The auto mode tries both MADV_NOHUGEPAGE and MADV_HUGEPAGE
+ * (if supported), otherwise just the default settings.
+ */
+static void run_latency_bench(int (*bench)(int size, int count,
+                                           int use_hugepage))
+{
+    if (cfg.hugepage != HUGEPAGE_AUTO)
+    {
+        if (!bench(cfg.latbench_size, cfg.latbench_count, cfg.hugepage))
+            printf("\nFailed to allocate the buffer in the selected huge pages mode\n");
+        return;
+    }
+    if (!bench(cfg.latbench_size, cfg.latbench_count, -1) ||
+        !bench(cfg.latbench_size, cfg.latbench_count, 1))
+    {
+        bench(cfg.latbench_size, cfg.latbench_count, 0);
+    }
+}
+
+static void latency_tests(void)
+{
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== Memory latency test                                                  ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Average time is measured for random memory accesses in the buffers   ==\n");
+    printf("== of different sizes. The larger is the buffer, the more significant   ==\n");
+    printf("== are relative contributions of TLB, L1/L2 cache misses and SDRAM      ==\n");
     printf("== accesses. For extremely large buffer sizes we are expecting to see   ==\n");
     printf("== page table walk with several requests to SDRAM for almost every      ==\n");
     printf("== memory access (though 64MiB is not nearly large enough to experience ==\n");
     printf("== this effect to its fullest).                                         ==\n");
     printf("==                                                                      ==\n");
-    printf("== Note 1: All the numbers are representing extra time, which needs to  ==\n");
-    printf("==         be added to L1 cache latency. The cycle timings for L1 cache ==\n");
-    printf("==         latency can be usually found in the processor documentation. ==\n");
-    printf("== Note 2: Dual random read means that we are simultaneously performing ==\n");
-    printf("==         two independent memory accesses at a time. In the case if    ==\n");
-    printf("==         the memory subsystem can't handle multiple outstanding       ==\n");
-    printf("==         requests, dual random read has the same timings as two       ==\n");
-    printf("==         single reads performed one after another.                    ==\n");
+    printf("== Note 1: All the numbers are representing extra time, which needs to  ==\n");
+    printf("==         be added to L1 cache latency. The cycle timings for L1 cache ==\n");
+    printf("==         latency can be usually found in the processor documentation. ==\n");
+    printf("== Note 2: Dual random read means that we are simultaneously performing ==\n");
+    printf("==         two independent memory accesses at a time. In the case if    ==\n");
+    printf("==         the memory subsystem can't handle multiple outstanding       ==\n");
+    printf("==         requests, dual random read has the same timings as two       ==\n");
+    printf("==         single reads performed one after another.                    ==\n");
+    printf("==========================================================================\n");
+    run_latency_bench(latency_bench);
+}
+
+static void pointer_chasing_tests(void)
+{
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== Memory latency test (pointer chasing)                                ==\n");
+    printf("==                                                                      ==\n");
+    printf("== All the cache lines of the block are linked into a single random     ==\n");
+    printf("== cycle, which is walked by a chain of dependent loads (each load      ==\n");
+    printf("== gets the address of the next one). Unlike the regular latency test,  ==\n");
+    printf("== the numbers show the full load-to-use latency for one hop, including ==\n");
+    printf("== the L1 cache latency.                                                ==\n");
+    printf("==========================================================================\n");
+    run_latency_bench(pointer_chase_bench);
+}
+
+static void mlp_tests(void)
+{
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== Memory-level parallelism test                                        ==\n");
+    printf("==                                                                      ==\n");
+    printf("== N independent pointer chasing chains are walked simultaneously in    ==\n");
+    printf("== the same random cycle. The numbers show the average time per access  ==\n");
+    printf("== and (in brackets) the effective memory-level parallelism, which is   ==\n");
+    printf("== the speedup relative to a single chain. The point where MLP stops    ==\n");
+    printf("== growing reveals how many cache misses can be outstanding at once.    ==\n");
+    printf("==========================================================================\n");
+    /* Only one huge pages mode in the auto mode, the table is big enough */
+    if (cfg.hugepage != HUGEPAGE_AUTO)
+    {
+        if (!mlp_bench(cfg.latbench_size, cfg.latbench_count, cfg.hugepage))
+            printf("\nFailed to allocate the buffer in the selected huge pages mode\n");
+    }
+    else if (!mlp_bench(cfg.latbench_size, cfg.latbench_count, 1))
+    {
+        mlp_bench(cfg.latbench_size, cfg.latbench_count, 0);
+    }
+}
+
+static void sweep_tests(int64_t maxsize)
+{
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== Memory bandwidth versus working set size                             ==\n");
+    printf("==                                                                      ==\n");
+    printf("== The same source and destination buffers are processed repeatedly,    ==\n");
+    printf("== so the small working sets stay in the caches. The bandwidth curve    ==\n");
+    printf("== shows the throughput of each cache level and of the memory.          ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Note: 1MB = 1000000 bytes, but the working set sizes use KiB and MiB ==\n");
+    printf("==========================================================================\n");
+    bandwidth_sweep(maxsize);
+}
+
+#define MISALIGN_MAX        64
+
+/*
+ * The kernels, which can copy between the buffers of any alignment (the
+ * other ones require 16 or more bytes aligned buffers on x86).
+ */
+static const char *misaligned_kernels[] =
+{
+    "standard memcpy",
+    "MOVSB copy",
+    "* unaligned copy",
+    "* (*, memcpy)",
+#ifdef __aarch64__
+    "NEON LDP/STP copy",
+    "NEON LD1/ST1 copy",
+#endif
+    NULL
+};
+
+static int misaligned_kernel_selected(const char *description)
+{
+    int i;
+    for (i = 0; misaligned_kernels[i]; i++)
+        if (glob_match(misaligned_kernels[i], description))
+            return kernel_selected(description);
+    return 0;
+}
+
+/*
+ * Copy 'size' bytes with the source and the destination offset by 0, 'step',
+ * 2 * 'step', ... 63 bytes from the start of a page and show the bandwidth
+ * as a grid. The source and destination buffers are placed at the same
+ * offset within a 4 KiB page, so the cells near the diagonal also show
+ * the 4K aliasing penalties.
+ */
+static void misaligned_bench(char *srcbuf, char *dstbuf, int size, int step,
+                             bench_info *bi)
+{
+    double speed, aligned = 0, worst = 0;
+    int src_offs, dst_offs, worst_src = 0, worst_dst = 0;
+    char name[128];
+    measurement m;
+
+    printf(" %s\n", bi->description);
+    printf("   %-9s :", "src \\ dst");
+    for (dst_offs = 0; dst_offs < MISALIGN_MAX; dst_offs += step)
+        printf(" %7d", dst_offs);
+    printf("\n");
+
+    for (src_offs = 0; src_offs < MISALIGN_MAX; src_offs += step)
+    {
+        printf("   %9d :", src_offs);
+        for (dst_offs = 0; dst_offs < MISALIGN_MAX; dst_offs += step)
+        {
+            speed = bandwidth_measure((int64_t *)(dstbuf + dst_offs),
+                                      (int64_t *)(srcbuf + src_offs),
+                                      NULL, size, cfg.blocksize, 0, bi->f,
+                                      &m);
+            sprintf(name, "%s, src +%d, dst +%d", bi->description,
+                    src_offs, dst_offs);
+            report_add("misaligned copy", name, size, 1, &m, "MB/s",
+                       buffer_page_mode());
+            if (src_offs == 0 && dst_offs == 0)
+                aligned = speed;
+            if (worst == 0 || speed < worst)
+            {
+                worst = speed;
+                worst_src = src_offs;
+                worst_dst = dst_offs;
+            }
+            printf(" %7.0f", speed);
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    printf("   worst: src +%d, dst +%d, %.1f MB/s (%.1f%% of aligned)\n\n",
+           worst_src, worst_dst, worst,
+           aligned > 0 ? worst / aligned * 100. : 0);
+}
+
+static void misaligned_tests(int size, int step)
+{
+    bench_info *groups[3], *bi;
+    char *poolbuf, *srcbuf, *dstbuf, buf1[32];
+    int64_t offs;
+    int i;
+
+    size -= size % 64;
+    /* Both buffers start at the beginning of a page */
+    offs = (size + MISALIGN_MAX + 4095) & ~4095;
+    poolbuf = (char *)alloc_pages(offs * 2, buffer_page_mode());
+    if (!poolbuf)
+    {
+        printf("\nFailed to allocate the buffers for the misaligned copy tests\n");
+        return;
+    }
+    srcbuf = poolbuf;
+    dstbuf = poolbuf + offs;
+    memset(poolbuf, 0, offs * 2);
+
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== Misaligned copy                                                      ==\n");
+    printf("==                                                                      ==\n");
+    printf("== The source and the destination buffers are offset by 0..63 bytes     ==\n");
+    printf("== independently, the grid shows the copy bandwidth in MB/s for every   ==\n");
+    printf("== combination of the offsets (rows: source, columns: destination).     ==\n");
+    printf("== Both buffers start at the same offset within a 4 KiB page, so the    ==\n");
+    printf("== cells near the diagonal may also show the 4K aliasing penalties.     ==\n");
+    printf("==========================================================================\n\n");
+    printf(" Copy size: %s\n\n", format_size(buf1, size));
+
+    groups[0] = libc_benchmarks;
+    groups[1] = get_asm_benchmarks();
+    groups[2] = get_plugin_benchmarks();
+    for (i = 0; i < 3; i++)
+        for (bi = groups[i]; bi->f; bi++)
+            if (misaligned_kernel_selected(bi->description))
+                misaligned_bench(srcbuf, dstbuf, size, step, bi);
+
+    free_pages(poolbuf);
+}
+
+#define PREFETCH_MIN_SIZE   (256 * 1024)
+#define PREFETCH_MAX_LINES  64
+
+typedef struct
+{
+    const char *description;
+    void      (*baseline)(int64_t *, int64_t *, int);
+    void      (*f[4])(int64_t *, int64_t *, int);
+} prefetch_info;
+
+static prefetch_info prefetch_benchmarks[] =
+{
+    { "C read", aligned_block_read,
+      { aligned_block_read_pfdist0, aligned_block_read_pfdist1,
+        aligned_block_read_pfdist2, aligned_block_read_pfdist3 } },
+    { "C copy", aligned_block_copy,
+      { aligned_block_copy_pfdist0, aligned_block_copy_pfdist1,
+        aligned_block_copy_pfdist2, aligned_block_copy_pfdist3 } },
+    { NULL, NULL, { NULL } }
+};
+
+/* The instructions generated for the __builtin_prefetch() locality hints */
+static const char *prefetch_hint_names[4] =
+#if defined(__i386__) || defined(__amd64__)
+{
+    "prefetchnta", "prefetcht2", "prefetcht1", "prefetcht0"
+};
+#elif defined(__aarch64__)
+{
+    "PLDL1STRM", "PLDL3KEEP", "PLDL2KEEP", "PLDL1KEEP"
+};
+#else
+{
+    "locality 0", "locality 1", "locality 2", "locality 3"
+};
+#endif
+
+/*
+ * Measure the kernel 'pi' with every prefetch hint and the distances of
+ * 1, 2, 4, ... PREFETCH_MAX_LINES cache lines on the buffers of 'size'
+ * bytes and show the best combination.
+ */
+static void prefetch_bench(int64_t *dstbuf, int64_t *srcbuf, int size,
+                           prefetch_info *pi)
+{
+    double speed, baseline, best = 0;
+    int hint, lines, best_hint = 0, best_lines = 0;
+    char name[128], buf1[32];
+    measurement m;
+
+    baseline = bandwidth_measure(dstbuf, srcbuf, NULL, size, cfg.blocksize,
+                                 0, pi->baseline, &m);
+    sprintf(name, "%s, no prefetch", pi->description);
+    report_add("prefetch", name, size, 1, &m, "MB/s", buffer_page_mode());
+
+    printf(" %s, %s (no prefetch: %.1f MB/s)\n", pi->description,
+           format_size(buf1, size), baseline);
+    printf("   %-14s :", "lines");
+    for (lines = 1; lines <= PREFETCH_MAX_LINES; lines *= 2)
+        printf(" %7d", lines);
+    printf("\n");
+
+    for (hint = 0; hint < 4; hint++)
+    {
+        printf("   %-14s :", prefetch_hint_names[hint]);
+        for (lines = 1; lines <= PREFETCH_MAX_LINES; lines *= 2)
+        {
+            set_prefetch_distance(lines * 64);
+            speed = bandwidth_measure(dstbuf, srcbuf, NULL, size,
+                                      cfg.blocksize, 0, pi->f[hint], &m);
+            sprintf(name, "%s, %s, %d lines", pi->description,
+                    prefetch_hint_names[hint], lines);
+            report_add("prefetch", name, size, 1, &m, "MB/s",
+                       buffer_page_mode());
+            if (speed > best)
+            {
+                best = speed;
+                best_hint = hint;
+                best_lines = lines;
+            }
+            printf(" %7.0f", speed);
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+
+    printf("   best: %s, %d lines (%d bytes), %.1f MB/s (%+.1f%%)\n\n",
+           prefetch_hint_names[best_hint], best_lines, best_lines * 64, best,
+           baseline > 0 ? (best / baseline - 1) * 100. : 0);
+    m.best = m.median = best;
+    m.stddev = 0;
+    sprintf(name, "%s, %s, %d lines", pi->description,
+            prefetch_hint_names[best_hint], best_lines);
+    report_add("prefetch best", name, size, 1, &m, "MB/s",
+               buffer_page_mode());
+}
+
+static void prefetch_tests(void)
+{
+    int64_t *srcbuf, *dstbuf;
+    void *poolbuf;
+    prefetch_info *pi;
+    int64_t size;
+
+    poolbuf = alloc_four_nonaliased_buffers((void **)&srcbuf, cfg.bufsize,
+                                            (void **)&dstbuf, cfg.bufsize,
+                                            NULL, 0, NULL, 0,
+                                            buffer_page_mode());
+    if (!poolbuf)
+    {
+        printf("\nFailed to allocate the buffers for the prefetch tests\n");
+        return;
+    }
+
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== Prefetch distance tuning                                             ==\n");
+    printf("==                                                                      ==\n");
+    printf("== The read and copy kernels prefetch the data 1, 2, 4, ... 64 cache    ==\n");
+    printf("== lines (64 bytes each) ahead with each of the prefetch hints. The     ==\n");
+    printf("== bandwidth in MB/s is shown for every combination and for the buffer  ==\n");
+    printf("== sizes from 256 KiB to --size (x4 steps), followed by the best one.   ==\n");
+    printf("==========================================================================\n\n");
+
+    for (pi = prefetch_benchmarks; pi->description; pi++)
+    {
+        if (!kernel_selected(pi->description))
+            continue;
+        for (size = PREFETCH_MIN_SIZE; ; size *= 4)
+        {
+            if (size > cfg.bufsize)
+                size = cfg.bufsize;
+            prefetch_bench(dstbuf, srcbuf, size - size % 64, pi);
+            if (size == cfg.bufsize)
+                break;
+        }
+    }
+
+    free_pages(poolbuf);
+}
+
+#define STRIDE_MIN          8
+#define STRIDE_MAX          (64 * 1024)
+
+/* Read one 8-byte element every 'stride' bytes */
+static void __attribute__((noinline)) strided_read(char *buf, int size,
+                                                   int stride)
+{
+    static volatile int64_t sink;
+    char *end = buf + size - 4 * stride;
+    int64_t t1 = 0, t2 = 0, t3 = 0, t4 = 0;
+    while (buf <= end)
+    {
+        t1 += *(int64_t *)(buf + 0 * stride);
+        t2 += *(int64_t *)(buf + 1 * stride);
+        t3 += *(int64_t *)(buf + 2 * stride);
+        t4 += *(int64_t *)(buf + 3 * stride);
+        buf += 4 * stride;
+    }
+    sink = t1 + t2 + t3 + t4;
+}
+
+/* Write one 8-byte element every 'stride' bytes */
+static void __attribute__((noinline)) strided_write(char *buf, int size,
+                                                    int stride)
+{
+    char *end = buf + size - 4 * stride;
+    while (buf <= end)
+    {
+        *(volatile int64_t *)(buf + 0 * stride) = 0;
+        *(volatile int64_t *)(buf + 1 * stride) = 0;
+        *(volatile int64_t *)(buf + 2 * stride) = 0;
+        *(volatile int64_t *)(buf + 3 * stride) = 0;
+        buf += 4 * stride;
+    }
+}
+
+/*
+ * Return the best bandwidth of the useful data (only the accessed elements
+ * are counted) for the strided reads or writes over 'size' bytes.
+ */
+static double strided_measure(char *buf, int size, int stride, int write,
+                              measurement *m)
+{
+    void (*f)(char *, int, int) = write ? strided_write : strided_read;
+    int i, n, loopcount, innerloopcount;
+    double t1, t2;
+    double speed, maxspeed, bytes;
+    double s, s0, s1, s2, t_start;
+    double samples[MAX_SAMPLES];
+
+    /* The number of the accessed bytes in one pass */
+    bytes = (double)(size / (4 * stride)) * 4 * sizeof(int64_t);
+
+    s = s0 = s1 = s2 = 0;
+    maxspeed   = 0;
+    perf_reset();
+    t_start = gettime();
+    for (n = 0; n < cfg.maxrepeats; n++)
+    {
+        f(buf, size, stride);
+        loopcount = 0;
+        innerloopcount = 1;
+        perf_start();
+        t1 = gettime();
+        do
+        {
+            loopcount += innerloopcount;
+            for (i = 0; i < innerloopcount; i++)
+                f(buf, size, stride);
+            innerloopcount *= 2;
+            t2 = gettime();
+        } while (t2 - t1 < cfg.sample_time);
+        perf_stop(bytes * loopcount);
+        speed = bytes * loopcount / (t2 - t1) / 1000000.;
+        samples[n] = speed;
+
+        s0 += 1;
+        s1 += speed;
+        s2 += speed * speed;
+
+        if (speed > maxspeed)
+            maxspeed = speed;
+
+        if (s0 > 2)
+        {
+            s = sqrt((s0 * s2 - s1 * s1) / (s0 * (s0 - 1)));
+            if (s < maxspeed / 1000.)
+                break;
+        }
+        if (out_of_time(t_start))
+            break;
+    }
+
+    measurement_from_samples(m, samples, s0, 1);
+    return maxspeed;
+}
+
+/*
+ * Access one 8-byte element every 8 bytes, 16 bytes, ... 64 KiB over
+ * a buffer of 'size' bytes and show the bandwidth of the useful data
+ * together with the number of the touched cache lines per second.
+ */
+static void strided_tests(int size, int with_write)
+{
+    static const char *modes[2] = { "read", "write" };
+    char *buf, name[64], buf1[32];
+    void *poolbuf;
+    double speed, lines, lines_per_byte;
+    measurement m;
+    int stride, write;
+
+    /* The same lower bound as for --stride-size, also for the --size fallback */
+    if (size < 4 * STRIDE_MAX)
+    {
+        printf("\nThe buffer is too small for the strided tests (at least %s)\n",
+               format_size(buf1, 4 * STRIDE_MAX));
+        return;
+    }
+    size -= size % STRIDE_MAX;
+    poolbuf = alloc_four_nonaliased_buffers((void **)&buf, size,
+                                            NULL, 0, NULL, 0, NULL, 0,
+                                            buffer_page_mode());
+    if (!poolbuf)
+    {
+        printf("\nFailed to allocate the buffer for the strided tests\n");
+        return;
+    }
+    memset(buf, 0, size);
+
+    printf("\n");
+    printf("==========================================================================\n");
+    printf("== Strided access bandwidth                                             ==\n");
+    printf("==                                                                      ==\n");
+    printf("== One 8-byte element is read (or written) every 'stride' bytes. The    ==\n");
+    printf("== useful bandwidth only counts the accessed elements, the number of    ==\n");
+    printf("== the touched 64-byte cache lines per second shows where the adjacent  ==\n");
+    printf("== line and the stride prefetchers stop helping.                        ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Note: 1MB = 1000000 bytes, 1M lines = 1000000 cache lines            ==\n");
+    printf("==========================================================================\n\n");
+    printf(" Buffer size: %s\n\n", format_size(buf1, size));
+
+    for (write = 0; write <= with_write; write++)
+    {
+        if (write)
+            printf("\n");
+        printf(" %-10s :  useful bandwidth  :   cache lines\n", modes[write]);
+        for (stride = STRIDE_MIN; stride <= STRIDE_MAX; stride *= 2)
+        {
+            speed = strided_measure(buf, size, stride, write, &m);
+            if (!(speed > 0))
+            {
+                /* No valid sample (for example, out of the time budget) */
+                printf(" %10s : %14s    : %14s\n",
+                       format_size(buf1, stride), "n/a", "n/a");
+                continue;
+            }
+            /* Every cache line is touched for the strides below 64 bytes */
+            lines_per_byte = (stride < 64 ? stride / 64. : 1.) /
+                             sizeof(int64_t);
+            lines = speed * lines_per_byte;
+            sprintf(name, "%s, stride %d", modes[write], stride);
+            report_add("strided", name, size, 1, &m, "MB/s",
+                       buffer_page_mode());
+            printf(" %10s : %9.1f MB/s    : %9.1f M lines/s\n",
+                   format_size(buf1, stride), speed, lines);
+            perf_print("     ", "B");
+            perf_report("strided", name, size, "B", buffer_page_mode());
+            m.best = lines;
+            m.median *= lines_per_byte;
+            m.stddev *= lines_per_byte;
+            report_add("strided", name, size, 1, &m, "M lines/s",
+                       buffer_page_mode());
+        }
+    }
+
+    free_pages(poolbuf);
+}
+
+#define SMALL_COPY_MAX      8192
+#define SMALL_COPY_CALLS    4096
+#define SMALL_COPY_TRACE    (1024 * 1024)
+/* The largest step of the copy and fill kernels (NEON unrolled, VFP) */
+#define SMALL_COPY_BLOCK    128
+
+/*
+ * The kernels, which can process any number of bytes. The other ones
+ * only work with the multiples of their block size and are only tested
+ * with the fixed sizes, which are multiples of SMALL_COPY_BLOCK.
+ */
+static const char *small_copy_any_size_kernels[] =
+{
+    "standard memcpy",
+    "standard memset",
+    "MOVSB copy",
+    "* (*, memcpy)",
+    "* (*, memset)",
+    NULL
+};
+
+/* The kernels tested unless selected by --kernels (and the plugins) */
+static const char *small_copy_default_kernels[] =
+{
+    "standard memcpy",
+    "standard memset",
+    "MOVSB copy",
+    "C copy",
+    "C fill",
+    "SSE2 copy",
+    "AVX copy",
+    "AVX-512 copy",
+    "NEON LDP/STP copy",
+    NULL
+};
+
+/*
+ * Only the copy and fill kernels (and the plugins) are used, the other
+ * ones process up to 256 bytes per iteration and read or write the data
+ * in ways, which don't make sense for the small copies. The 2-pass copies
+ * need a temporary buffer.
+ */
+static int small_copy_kernel_selected(bench_info *bi)
+{
+    const char *description = bi->description;
+    int i;
+    if (!plugin_benchmark(description) &&
+        (bi->use_tmpbuf || (!glob_match("* copy*", description) &&
+                            !glob_match("* fill*", description) &&
+                            !glob_match("* memcpy", description) &&
+                            !glob_match("* memset", description))))
+        return 0;
+    if (cfg.kernels)
+        return kernel_selected(description);
+    if (plugin_benchmark(description))
+        return 1;
+    for (i = 0; small_copy_default_kernels[i]; i++)
+        if (strcmp(small_copy_default_kernels[i], description) == 0)
+            return 1;
+    return 0;
+}
+
+static int small_copy_any_size(const char *description)
+{
+    int i;
+    for (i = 0; small_copy_any_size_kernels[i]; i++)
+        if (glob_match(small_copy_any_size_kernels[i], description))
+            return 1;
+    return 0;
+}
+
+/*
+ * Call 'f' for every size from the 'sizes' array in a loop and return the
+ * best time per call in nanoseconds. The buffers are small enough to stay
+ * in the L1 cache, so the numbers show the call overhead, the size dispatch
+ * and the branch mispredictions rather than the memory bandwidth. The
+ * samples are 10 times shorter than in the bandwidth tests, because there
+ * are many more of them.
+ */
+static double small_copy_measure(int64_t *dstbuf, int64_t *srcbuf,
+                                 const int *sizes, int n,
+                                 void (*f)(int64_t *, int64_t *, int),
+                                 measurement *m)
+{
+    int i, j, r, loopcount, innerloopcount;
+    double t1, t2;
+    double ns, minns;
+    double s, s0, s1, s2, t_start;
+    double samples[MAX_SAMPLES];
+
+    s = s0 = s1 = s2 = 0;
+    minns = 0;
+    perf_reset();
+    t_start = gettime();
+    for (j = 0; j < cfg.maxrepeats; j++)
+    {
+        for (i = 0; i < n; i++)
+            f(dstbuf, srcbuf, sizes[i]);
+        loopcount = 0;
+        innerloopcount = 1;
+        perf_start();
+        t1 = gettime();
+        do
+        {
+            loopcount += innerloopcount;
+            for (r = 0; r < innerloopcount; r++)
+                for (i = 0; i < n; i++)
+                    f(dstbuf, srcbuf, sizes[i]);
+            innerloopcount *= 2;
+            t2 = gettime();
+        } while (t2 - t1 < cfg.sample_time / 10);
+        perf_stop((double)n * loopcount);
+        ns = (t2 - t1) * 1000000000. / ((double)n * loopcount);
+        samples[j] = ns;
+
+        s0 += 1;
+        s1 += ns;
+        s2 += ns * ns;
+
+        if (minns == 0 || ns < minns)
+            minns = ns;
+
+        if (s0 > 2)
+        {
+            s = sqrt((s0 * s2 - s1 * s1) / (s0 * (s0 - 1)));
+            if (s < minns / 1000.)
+                break;
+        }
+        if (out_of_time(t_start))
+            break;
+    }
+
+    measurement_from_samples(m, samples, s0, 0);
+    return minns;
+}
+
+static void small_copy_row(int64_t *dstbuf, int64_t *srcbuf,
+                           const int *sizes, int n, bench_info *bi,
+                           const char *row, int64_t size)
+{
+    double ns, hz = timer_cycles_per_second();
+    char name[128];
+    measurement m;
+
+    ns = small_copy_measure(dstbuf, srcbuf, sizes, n, bi->f, &m);
+    if (hz > 0)
+        printf("   %-30s : %8.2f : %8.1f\n", row, ns, ns * hz / 1000000000.);
+    else
+        printf("   %-30s : %8.2f : %8s\n", row, ns, "-");
+    fflush(stdout);
+    sprintf(name, "%s, %s", bi->description, row);
+    report_add("small copy", name, size, 1, &m, "ns", buffer_page_mode());
+    perf_print("     ", "call");
+    perf_report("small copy", name, size, "call", buffer_page_mode());
+}
+
+static int compare_int(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+/* The Fisher-Yates shuffle of the array */
+static void shuffle_sizes(int *sizes, int n)
+{
+    int i, j, tmp;
+    for (i = n - 1; i > 0; i--)
+    {
+        j = rand32() % (i + 1);
+        tmp = sizes[i];
+        sizes[i] = sizes[j];
+        sizes[j] = tmp;
+    }
+}
+
+/*
+ * Read the recorded sizes (one per line, in the order of the calls) from
+ * the file. The sizes outside of the 1..8192 range are skipped. Returns
+ * the number of the sizes or -1 on error.
+ */
+static int read_size_distribution(const char *filename, int *sizes, int max)
+{
+    FILE *f = fopen(filename, "r");
+    long size;
+    int n = 0;
+
+    if (!f)
+        return -1;
+    while (n < max && fscanf(f, "%ld", &size) == 1)
+    {
+        if (size >= 1 && size <= SMALL_COPY_MAX)
+            sizes[n++] = (int)size;
+    }
+    fclose(f);
+    return n;
+}
+
+/*
+ * Measure the time per call of memcpy, memset, REP MOVSB and the copy and
+ * fill kernels of this program for the sizes from 1 byte to 8 KiB. Each
+ * kernel is tested with the fixed sizes (perfectly predictable branches),
+ * with the uniformly distributed random sizes (sorted to keep the branches
+ * predictable and shuffled to defeat the branch predictor) and with the
+ * sizes from the 'distfile' (in the recorded order, sorted and shuffled).
+ */
+static void small_copy_tests(const char *distfile)
+{
+    static const int random_max[] = { 16, 128, 1024, SMALL_COPY_MAX };
+    bench_info *groups[4], *bi;
+    int64_t *srcbuf, *dstbuf;
+    void *poolbuf;
+    int *sizes, *trace = NULL;
+    int i, j, k, size, ntrace = 0;
+    char row[64];
+
+    if (distfile)
+    {
+        trace = (int *)malloc(SMALL_COPY_TRACE * sizeof(int));
+        if (trace)
+            ntrace = read_size_distribution(distfile, trace, SMALL_COPY_TRACE);
+        if (ntrace <= 0)
+        {
+            printf("\nFailed to read the copy sizes from '%s'\n", distfile);
+            free(trace);
+            return;
+        }
+    }
+
+    sizes = (int *)malloc((ntrace > SMALL_COPY_CALLS ? ntrace :
+                           SMALL_COPY_CALLS) * sizeof(int));
+    poolbuf = alloc_four_nonaliased_buffers((void **)&srcbuf, SMALL_COPY_MAX,
+                                            (void **)&dstbuf, SMALL_COPY_MAX,
+                                            NULL, 0, NULL, 0,
+                                            buffer_page_mode());
+    if (!sizes || !poolbuf)
+    {
+        printf("\nFailed to allocate the buffers for the small copy tests\n");
+        free(sizes);
+        free(trace);
+        if (poolbuf)
+            free_pages(poolbuf);
+        return;
+    }
+    memset(srcbuf, 0, SMALL_COPY_MAX);
+    memset(dstbuf, 0, SMALL_COPY_MAX);
+
+    printf("\n");
     printf("==========================================================================\n");
+    printf("== Small copy latency                                                   ==\n");
+    printf("==                                                                      ==\n");
+    printf("== The time per call for the copies (or fills) from 1 byte to 8 KiB in  ==\n");
+    printf("== the buffers, which stay in the L1 cache. The fixed sizes keep the    ==\n");
+    printf("== branches predictable, the shuffled random sizes show the cost of the ==\n");
+    printf("== branch mispredictions. The cycles are the TSC cycles (if the TSC     ==\n");
+    printf("== frequency is known), the real core cycles are shown with --perf.     ==\n");
+    printf("==                                                                      ==\n");
+    printf("== Note: only the copy and fill kernels are used. The ones other than   ==\n");
+    printf("==       memcpy, memset and MOVSB are only tested with the multiples of ==\n");
+    printf("==       128 bytes and not with the random sizes.                       ==\n");
+    printf("==========================================================================\n\n");
+
+    groups[0] = libc_benchmarks;
+    groups[1] = c_benchmarks;
+    groups[2] = get_asm_benchmarks();
+    groups[3] = get_plugin_benchmarks();
+    for (k = 0; k < 4; k++)
+    {
+        for (bi = groups[k]; bi->f; bi++)
+        {
+            if (!small_copy_kernel_selected(bi))
+                continue;
+            printf(" %s\n", bi->description);
+            printf("   %-30s : %8s : %8s\n", "size", "ns/call", "cycles");
+            for (size = 1; size <= SMALL_COPY_MAX; size *= 2)
+            {
+                if (size % SMALL_COPY_BLOCK != 0 &&
+                    !small_copy_any_size(bi->description))
+                    continue;
+                format_size(row, size);
+                small_copy_row(dstbuf, srcbuf, &size, 1, bi, row, size);
+            }
+            if (!small_copy_any_size(bi->description))
+            {
+                printf("\n");
+                continue;
+            }
+            for (i = 0; i < (int)(sizeof(random_max) / sizeof(random_max[0])); i++)
+            {
+                for (j = 0; j < SMALL_COPY_CALLS; j++)
+                    sizes[j] = 1 + rand32() % random_max[i];
+                qsort(sizes, SMALL_COPY_CALLS, sizeof(int), compare_int);
+                sprintf(row, "random 1..%d, sorted", random_max[i]);
+                small_copy_row(dstbuf, srcbuf, sizes, SMALL_COPY_CALLS, bi,
+                               row, random_max[i]);
+                shuffle_sizes(sizes, SMALL_COPY_CALLS);
+                sprintf(row, "random 1..%d, shuffled", random_max[i]);
+                small_copy_row(dstbuf, srcbuf, sizes, SMALL_COPY_CALLS, bi,
+                               row, random_max[i]);
+            }
+            if (trace)
+            {
+                small_copy_row(dstbuf, srcbuf, trace, ntrace, bi,
+                               "recorded, original order", SMALL_COPY_MAX);
+                memcpy(sizes, trace, ntrace * sizeof(int));
+                qsort(sizes, ntrace, sizeof(int), compare_int);
+                small_copy_row(dstbuf, srcbuf, sizes, ntrace, bi,
+                               "recorded, sorted", SMALL_COPY_MAX);
+                shuffle_sizes(sizes, ntrace);
+                small_copy_row(dstbuf, srcbuf, sizes, ntrace, bi,
+                               "recorded, shuffled", SMALL_COPY_MAX);
+            }
+            printf("\n");
+        }
+    }
+
+    free_pages(poolbuf);
+    free(sizes);
+    free(trace);
+}
+
+/* Return the value of the "--name=value" option or NULL if it doesn't match */
+static const char *option_value(const char *arg, const char *name)
+{
+    int n = strlen(name);
+    if (strncmp(arg, name, n) == 0 && arg[n] == '=')
+        return arg + n + 1;
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    int i, tests = 0, mt_threads = 0, load_threads = 0;
+    int64_t size, sweep_max = 1024 * 1024 * 1024;
+    int64_t tlb_max = 1024 * 1024 * 1024;
+    int stride_size = 0, stride_write = 0;
+    int align_size = 64 * 1024, align_step = 8;
+    const char *size_distribution = NULL;
+    int report_format = REPORT_TEXT;
+    const char *report_filename = NULL;
+    const char *compare_filename = NULL;
+    double compare_threshold = 5;
+    const char *timer = NULL;
+    const char *v;
+    int use_perf = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if ((v = option_value(argv[i], "--tests")))
+        {
+            if (!parse_test_groups(v, &tests))
+            {
+                fprintf(stderr, "Unknown test group in '%s'\n", v);
+                return 1;
+            }
+        }
+        else if ((v = option_value(argv[i], "--kernels")))
+        {
+            cfg.kernels = v;
+        }
+        else if ((v = option_value(argv[i], "--plugin")))
+        {
+            if (!plugin_load(v))
+                return 1;
+        }
+        else if (strcmp(argv[i], "--list") == 0)
+        {
+            print_benchmark_list("C", c_benchmarks);
+            print_benchmark_list("libc", libc_benchmarks);
+            print_benchmark_list("asm", get_asm_benchmarks());
+            print_benchmark_list("plugin", get_plugin_benchmarks());
+            print_benchmark_list("framebuffer",
+                                 get_asm_framebuffer_benchmarks());
+            return 0;
+        }
+        else if ((v = option_value(argv[i], "--threads")))
+        {
+            mt_threads = atoi(v);
+            tests |= TEST_THREADS;
+        }
+        else if (strcmp(argv[i], "--numa") == 0)
+        {
+            tests |= TEST_NUMA;
+        }
+        else if (strcmp(argv[i], "--pointer-chasing") == 0)
+        {
+            tests |= TEST_POINTER_CHASING;
+        }
+        else if (strcmp(argv[i], "--mlp") == 0)
+        {
+            tests |= TEST_MLP;
+        }
+        else if (strcmp(argv[i], "--detect-caches") == 0)
+        {
+            tests |= TEST_DETECT_CACHES;
+        }
+        else if (strcmp(argv[i], "--sweep") == 0)
+        {
+            tests |= TEST_SWEEP;
+        }
+        else if (strcmp(argv[i], "--tlb") == 0)
+        {
+            tests |= TEST_TLB;
+        }
+        else if (strcmp(argv[i], "--loaded-latency") == 0)
+        {
+            tests |= TEST_LOADED_LATENCY;
+        }
+        else if (strcmp(argv[i], "--core-to-core") == 0)
+        {
+            tests |= TEST_CORE_TO_CORE;
+        }
+        else if (strcmp(argv[i], "--atomics") == 0)
+        {
+            tests |= TEST_ATOMICS;
+        }
+        else if (strcmp(argv[i], "--stream") == 0)
+        {
+            tests |= TEST_STREAM;
+        }
+        else if (strcmp(argv[i], "--strided") == 0)
+        {
+            tests |= TEST_STRIDED;
+        }
+        else if (strcmp(argv[i], "--stride-write") == 0)
+        {
+            stride_write = 1;
+        }
+        else if (strcmp(argv[i], "--prefetch-tuning") == 0)
+        {
+            tests |= TEST_PREFETCH;
+        }
+        else if (strcmp(argv[i], "--misaligned") == 0)
+        {
+            tests |= TEST_MISALIGNED;
+        }
+        else if (strcmp(argv[i], "--small-copy") == 0)
+        {
+            tests |= TEST_SMALL_COPY;
+        }
+        else if ((v = option_value(argv[i], "--load-threads")) &&
+                 atoi(v) > 0 && atoi(v) < MAX_CPUS)
+        {
+            load_threads = atoi(v);
+        }
+        else if ((v = option_value(argv[i], "--size")) &&
+                 (size = parse_size(v)) > 0 && size < (1U << 31))
+        {
+            cfg.bufsize = size;
+        }
+        else if ((v = option_value(argv[i], "--blocksize")) &&
+                 (size = parse_size(v)) >= 256 && size <= 64 * 1024 * 1024)
+        {
+            cfg.blocksize = size & ~255;
+        }
+        else if ((v = option_value(argv[i], "--latency-size")) &&
+                 (size = parse_size(v)) >= 1024 && size < (1U << 31))
+        {
+            cfg.latbench_size = size;
+        }
+        else if ((v = option_value(argv[i], "--latency-count")) &&
+                 atoi(v) >= 16)
+        {
+            cfg.latbench_count = atoi(v);
+        }
+        else if ((v = option_value(argv[i], "--sweep-max")) &&
+                 (size = parse_size(v)) >= SWEEP_MIN_SIZE)
+        {
+            sweep_max = size;
+        }
+        else if ((v = option_value(argv[i], "--tlb-max")) &&
+                 (size = parse_size(v)) >= TLB_MIN_PAGES * TLB_PAGE_SIZE &&
+                 size / TLB_PAGE_SIZE < (1U << 31))
+        {
+            tlb_max = size;
+        }
+        else if ((v = option_value(argv[i], "--stride-size")) &&
+                 (size = parse_size(v)) >= 4 * STRIDE_MAX &&
+                 size < (1U << 31))
+        {
+            stride_size = (int)size;
+        }
+        else if ((v = option_value(argv[i], "--align-size")) &&
+                 (size = parse_size(v)) >= 64 && size < (1 << 30))
+        {
+            align_size = (int)size;
+        }
+        else if ((v = option_value(argv[i], "--align-step")) &&
+                 atoi(v) >= 1 && atoi(v) < MISALIGN_MAX)
+        {
+            align_step = atoi(v);
+        }
+        else if ((v = option_value(argv[i], "--size-distribution")) && *v)
+        {
+            size_distribution = v;
+            tests |= TEST_SMALL_COPY;
+        }
+        else if ((v = option_value(argv[i], "--repeats")) &&
+                 atoi(v) > 0 && atoi(v) <= MAX_SAMPLES)
+        {
+            cfg.maxrepeats = atoi(v);
+        }
+        else if ((v = option_value(argv[i], "--budget")) && atof(v) > 0)
+        {
+            cfg.time_budget = atof(v);
+        }
+        else if ((v = option_value(argv[i], "--sample-time")) && atof(v) > 0)
+        {
+            cfg.sample_time = atof(v);
+        }
+        else if ((v = option_value(argv[i], "--timer")))
+        {
+            timer = v;
+        }
+        else if (strcmp(argv[i], "--perf") == 0)
+        {
+            use_perf = 1;
+        }
+        else if ((v = option_value(argv[i], "--hugepage")) &&
+                 (strcmp(v, "auto") == 0 || strcmp(v, "on") == 0 ||
+                  strcmp(v, "off") == 0 || parse_page_mode(v, &cfg.hugepage)))
+        {
+            if (strcmp(v, "auto") == 0)
+                cfg.hugepage = HUGEPAGE_AUTO;
+            else if (strcmp(v, "on") == 0)
+                cfg.hugepage = PAGES_THP;
+            else if (strcmp(v, "off") == 0)
+                cfg.hugepage = PAGES_4K;
+        }
+        else if (strcmp(argv[i], "--format=text") == 0)
+        {
+            report_format = REPORT_TEXT;
+        }
+        else if (strcmp(argv[i], "--format=json") == 0)
+        {
+            report_format = REPORT_JSON;
+        }
+        else if (strcmp(argv[i], "--format=csv") == 0)
+        {
+            report_format = REPORT_CSV;
+        }
+        else if ((v = option_value(argv[i], "--output")))
+        {
+            report_filename = v;
+        }
+        else if ((v = option_value(argv[i], "--compare")))
+        {
+            compare_filename = v;
+        }
+        else if ((v = option_value(argv[i], "--threshold")) && atof(v) >= 0)
+        {
+            compare_threshold = atof(v);
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (!timer_init(timer))
+    {
+        fprintf(stderr, "Timer '%s' is not available\n", timer);
+        return 1;
+    }
+
+    if (tests == 0)
+        tests = TEST_DEFAULT;
+    /* The sizes must be multiples of the temporary buffer size */
+    cfg.bufsize -= cfg.bufsize % cfg.blocksize;
+    if (cfg.bufsize == 0)
+        cfg.bufsize = cfg.blocksize;
+    sweep_max -= sweep_max % cfg.blocksize;
+    /* Leave the time for at least 3 measurements within the budget */
+    if (cfg.time_budget > 0 && cfg.sample_time > cfg.time_budget / 3)
+        cfg.sample_time = cfg.time_budget / 3;
+
+    if (!report_open(report_format, report_filename))
+    {
+        fprintf(stderr, "Failed to open '%s' for writing\n", report_filename);
+        return 1;
+    }
+    atexit(report_close);
+    if (compare_filename &&
+        !report_compare_open(compare_filename, compare_threshold))
+    {
+        fprintf(stderr, "Failed to read the baseline from '%s'\n",
+                compare_filename);
+        return 1;
+    }
+
+    printf("tinymembench v" VERSION " (simple benchmark for memory throughput and latency)\n");
+    printf("\ntimer: %s, resolution %.1f ns", timer_name(),
+           timer_resolution() * 1000000000.);
+    if (timer_cycles_per_second() > 0)
+        printf(", TSC frequency %.1f MHz", timer_cycles_per_second() / 1000000.);
+    printf("\n");
+    printf("pages: %s\n", cfg.hugepage == HUGEPAGE_AUTO ?
+           "default (latency tests: MADV_NOHUGEPAGE and MADV_HUGEPAGE)" :
+           page_mode_description(cfg.hugepage));
+    if (use_perf && perf_init() > 0)
+        printf("perf counters: %s\n", perf_counter_names());
+    else if (use_perf)
+        printf("perf counters: not available\n");
+
+    if (tests & TEST_BANDWIDTH)
+        bandwidth_tests();
+    if (tests & TEST_FRAMEBUFFER)
+        framebuffer_tests();
+    if (tests & TEST_LATENCY)
+        latency_tests();
+    if (tests & TEST_THREADS)
+        mt_bandwidth_tests(mt_threads);
+    if (tests & TEST_NUMA)
+        numa_tests(cfg.latbench_size, cfg.latbench_count);
+    if (tests & TEST_POINTER_CHASING)
+        pointer_chasing_tests();
+    if (tests & TEST_MLP)
+        mlp_tests();
+    if (tests & TEST_DETECT_CACHES)
+        cache_detect_tests(cfg.latbench_count);
+    if (tests & TEST_SWEEP)
+        sweep_tests(sweep_max);
+    if (tests & TEST_TLB)
+        tlb_tests(tlb_max, cfg.latbench_count);
+    if (tests & TEST_LOADED_LATENCY)
+        loaded_latency_tests(load_threads);
+    if (tests & TEST_CORE_TO_CORE)
+        c2c_tests();
+    if (tests & TEST_ATOMICS)
+        atomic_tests(mt_threads);
+    if (tests & TEST_STREAM)
+        stream_tests();
+    if (tests & TEST_STRIDED)
+        strided_tests(stride_size ? stride_size : cfg.bufsize, stride_write);
+    if (tests & TEST_PREFETCH)
+        prefetch_tests();
+    if (tests & TEST_MISALIGNED)
+        misaligned_tests(align_size, align_step);
+    if (tests & TEST_SMALL_COPY)
+        small_copy_tests(size_distribution);
 
-    if (!latency_bench(latbench_size, latbench_count, -1) ||
-        !latency_bench(latbench_size, latbench_count, 1))
+    if (compare_filename)
     {
-        latency_bench(latbench_size, latbench_count, 0);
+        /* Keep the machine-readable report on stdout free of the summary */
+        FILE *f = report_format != REPORT_TEXT && !report_filename ?
+                  stderr : stdout;
+        fprintf(f, "\n");
+        fprintf(f, "==========================================================================\n");
+        fprintf(f, "== Comparison with the baseline                                         ==\n");
+        fprintf(f, "==                                                                      ==\n");
+        fprintf(f, "== The best results of this run compared with the same tests in the     ==\n");
+        fprintf(f, "== baseline. A regression is a result, which is worse by more than the  ==\n");
+        fprintf(f, "== threshold and by more than twice the combined standard deviation.    ==\n");
+        fprintf(f, "==========================================================================\n");
+        if (report_compare_summary(f) > 0)
+            return 2;
     }
 
     return 0;
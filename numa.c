@@ -0,0 +1,223 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#include "numa.h"
+
+#if defined(__linux__) && defined(__NR_set_mempolicy) && \
+    defined(__NR_get_mempolicy)
+
+/* From linux/mempolicy.h, which is not always available */
+#define MPOL_DEFAULT     0
+#define MPOL_BIND        2
+#define MPOL_F_NODE      (1 << 0)
+#define MPOL_F_ADDR      (1 << 1)
+
+#define NODEMASK_BITS    (8 * sizeof(unsigned long))
+
+/*
+ * Parse a list in the "0-3,8,10-11" format (as used in sysfs) and call
+ * 'callback' for every number in it.
+ */
+static void parse_list(const char *str,
+                       void (*callback)(int number, void *arg), void *arg)
+{
+    char *end;
+    long first, last;
+    while (*str)
+    {
+        while (*str && !isdigit(*str))
+            str++;
+        if (!*str)
+            break;
+        first = last = strtol(str, &end, 10);
+        str = end;
+        if (*str == '-')
+        {
+            last = strtol(str + 1, &end, 10);
+            str = end;
+        }
+        while (first <= last)
+            callback(first++, arg);
+    }
+}
+
+static int read_sysfs_line(const char *path, char *buffer, int bufsize)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return 0;
+    if (!fgets(buffer, bufsize, f))
+        buffer[0] = 0;
+    fclose(f);
+    return 1;
+}
+
+typedef struct
+{
+    numa_node_info *nodes;
+    int             nnodes;
+    int             maxnodes;
+    const int      *allowed_cpus;
+    int             nallowed;
+} topology_ctx;
+
+static void add_node(int id, void *arg)
+{
+    topology_ctx *ctx = (topology_ctx *)arg;
+    if (ctx->nnodes >= ctx->maxnodes)
+        return;
+    memset(&ctx->nodes[ctx->nnodes], 0, sizeof(numa_node_info));
+    ctx->nodes[ctx->nnodes].id = id;
+    ctx->nnodes++;
+}
+
+static void mark_node_with_memory(int id, void *arg)
+{
+    topology_ctx *ctx = (topology_ctx *)arg;
+    int i;
+    for (i = 0; i < ctx->nnodes; i++)
+        if (ctx->nodes[i].id == id)
+            ctx->nodes[i].has_memory = 1;
+}
+
+static void add_cpu(int cpu, void *arg)
+{
+    topology_ctx *ctx = (topology_ctx *)arg;
+    numa_node_info *node = &ctx->nodes[ctx->nnodes - 1];
+    int i;
+    for (i = 0; i < ctx->nallowed; i++)
+    {
+        if (ctx->allowed_cpus[i] == cpu &&
+            node->ncpus < (int)(sizeof(node->cpus) / sizeof(node->cpus[0])))
+        {
+            node->cpus[node->ncpus++] = cpu;
+            break;
+        }
+    }
+}
+
+int numa_get_nodes(numa_node_info *nodes, int maxnodes,
+                   const int *allowed_cpus, int nallowed)
+{
+    topology_ctx ctx;
+    char buffer[4096], path[256];
+    int i, nnodes;
+
+    ctx.nodes = nodes;
+    ctx.nnodes = 0;
+    ctx.maxnodes = maxnodes;
+    ctx.allowed_cpus = allowed_cpus;
+    ctx.nallowed = nallowed;
+
+    if (!read_sysfs_line("/sys/devices/system/node/online",
+                         buffer, sizeof(buffer)))
+        goto fallback;
+    parse_list(buffer, add_node, &ctx);
+    if (ctx.nnodes == 0)
+        goto fallback;
+
+    if (read_sysfs_line("/sys/devices/system/node/has_memory",
+                        buffer, sizeof(buffer)))
+        parse_list(buffer, mark_node_with_memory, &ctx);
+    else
+        for (i = 0; i < ctx.nnodes; i++)
+            nodes[i].has_memory = 1;
+
+    /* Now fill the CPU lists, temporarily treating each node as the last */
+    nnodes = ctx.nnodes;
+    for (i = 0; i < nnodes; i++)
+    {
+        sprintf(path, "/sys/devices/system/node/node%d/cpulist", nodes[i].id);
+        if (!read_sysfs_line(path, buffer, sizeof(buffer)))
+            continue;
+        ctx.nnodes = i + 1;
+        parse_list(buffer, add_cpu, &ctx);
+    }
+    return nnodes;
+
+fallback:
+    memset(&nodes[0], 0, sizeof(numa_node_info));
+    nodes[0].has_memory = 1;
+    for (i = 0; i < nallowed && i < (int)(sizeof(nodes[0].cpus) /
+                                          sizeof(nodes[0].cpus[0])); i++)
+        nodes[0].cpus[nodes[0].ncpus++] = allowed_cpus[i];
+    return 1;
+}
+
+int numa_bind_memory(int node)
+{
+    unsigned long nodemask[MAX_NUMA_NODES / NODEMASK_BITS + 1];
+    if (node < 0)
+        return syscall(__NR_set_mempolicy, MPOL_DEFAULT, NULL, 0) == 0;
+    if (node >= MAX_NUMA_NODES)
+        return 0;
+    memset(nodemask, 0, sizeof(nodemask));
+    nodemask[node / NODEMASK_BITS] |= 1UL << (node % NODEMASK_BITS);
+    return syscall(__NR_set_mempolicy, MPOL_BIND, nodemask,
+                   sizeof(nodemask) * 8) == 0;
+}
+
+int numa_node_of_address(void *addr)
+{
+    int node = -1;
+    if (syscall(__NR_get_mempolicy, &node, NULL, 0, addr,
+                MPOL_F_NODE | MPOL_F_ADDR) != 0)
+        return -1;
+    return node;
+}
+
+#else
+
+int numa_get_nodes(numa_node_info *nodes, int maxnodes,
+                   const int *allowed_cpus, int nallowed)
+{
+    int i;
+    memset(&nodes[0], 0, sizeof(numa_node_info));
+    nodes[0].has_memory = 1;
+    for (i = 0; i < nallowed && i < (int)(sizeof(nodes[0].cpus) /
+                                          sizeof(nodes[0].cpus[0])); i++)
+        nodes[0].cpus[nodes[0].ncpus++] = allowed_cpus[i];
+    return 1;
+}
+
+int numa_bind_memory(int node)
+{
+    return node <= 0;
+}
+
+int numa_node_of_address(void *addr)
+{
+    return -1;
+}
+
+#endif
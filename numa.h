@@ -0,0 +1,61 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NUMA_H__
+#define __NUMA_H__
+
+#include "threads.h"
+
+#define MAX_NUMA_NODES 64
+
+typedef struct
+{
+    int id;
+    int has_memory;
+    int ncpus;
+    int cpus[MAX_CPUS];
+} numa_node_info;
+
+/*
+ * Read the NUMA topology from /sys/devices/system/node. Only the CPUs
+ * from the 'allowed_cpus' list are taken into account. If the topology
+ * information is not available, then a single node 0 is reported, which
+ * has memory and all the allowed CPUs. Returns the number of nodes.
+ */
+int numa_get_nodes(numa_node_info *nodes, int maxnodes,
+                   const int *allowed_cpus, int nallowed);
+
+/*
+ * Make all the future memory allocations of the calling thread use only
+ * the specified NUMA node (or restore the default policy if the node
+ * is negative). Returns 1 on success.
+ */
+int numa_bind_memory(int node);
+
+/*
+ * Find the NUMA node, which backs the memory page at the given address.
+ * Returns -1 if unknown.
+ */
+int numa_node_of_address(void *addr);
+
+#endif
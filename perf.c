@@ -0,0 +1,225 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "perf.h"
+#include "report.h"
+
+#if defined(__linux__) && defined(__NR_perf_event_open)
+
+#define HW_CACHE_EVENT(cache, op, result) \
+    ((cache) | ((op) << 8) | ((result) << 16))
+
+static struct
+{
+    const char *name;
+    uint32_t    type;
+    uint64_t    config;
+} perf_events[] =
+{
+    { "cycles",          PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions",    PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "LLC-misses",      PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { "dTLB-misses",     PERF_TYPE_HW_CACHE,
+      HW_CACHE_EVENT(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                     PERF_COUNT_HW_CACHE_RESULT_MISS) },
+    /* Memory requests which leave the core (offcore on Intel) */
+    { "memory-reads",    PERF_TYPE_HW_CACHE,
+      HW_CACHE_EVENT(PERF_COUNT_HW_CACHE_NODE, PERF_COUNT_HW_CACHE_OP_READ,
+                     PERF_COUNT_HW_CACHE_RESULT_ACCESS) },
+    { "bus-cycles",      PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES },
+    { "backend-stalls",  PERF_TYPE_HARDWARE,
+      PERF_COUNT_HW_STALLED_CYCLES_BACKEND },
+    { NULL, 0, 0 }
+};
+
+#define PERF_MAX_COUNTERS (sizeof(perf_events) / sizeof(perf_events[0]))
+
+static int    perf_fd[PERF_MAX_COUNTERS];
+static int    perf_event_index[PERF_MAX_COUNTERS];
+static int    perf_ncounters;
+static double perf_units;
+static char   perf_names[256];
+
+static int open_counter(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    /* The unprivileged users can usually count only the user space */
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    /* Needed to scale the counts if the counters are multiplexed */
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+int perf_init(void)
+{
+    int i, fd;
+
+    /* Each counter is separate, so that the unsupported ones don't matter */
+    for (i = 0; perf_events[i].name; i++)
+    {
+        fd = open_counter(perf_events[i].type, perf_events[i].config);
+        if (fd < 0)
+            continue;
+        perf_fd[perf_ncounters] = fd;
+        perf_event_index[perf_ncounters] = i;
+        if (perf_ncounters)
+            strcat(perf_names, ", ");
+        strcat(perf_names, perf_events[i].name);
+        perf_ncounters++;
+    }
+    return perf_ncounters;
+}
+
+void perf_reset(void)
+{
+    int i;
+    for (i = 0; i < perf_ncounters; i++)
+        ioctl(perf_fd[i], PERF_EVENT_IOC_RESET, 0);
+    perf_units = 0;
+}
+
+void perf_start(void)
+{
+    int i;
+    for (i = 0; i < perf_ncounters; i++)
+        ioctl(perf_fd[i], PERF_EVENT_IOC_ENABLE, 0);
+}
+
+void perf_stop(double units)
+{
+    int i;
+    for (i = 0; i < perf_ncounters; i++)
+        ioctl(perf_fd[i], PERF_EVENT_IOC_DISABLE, 0);
+    perf_units += units;
+}
+
+/* Read the counter 'i' divided by the number of units, -1 on failure */
+static double read_counter(int i)
+{
+    uint64_t data[3]; /* value, time enabled, time running */
+
+    if (read(perf_fd[i], data, sizeof(data)) != sizeof(data) ||
+        data[2] == 0 || perf_units <= 0)
+        return -1;
+    return (double)data[0] * ((double)data[1] / data[2]) / perf_units;
+}
+
+#else
+
+#define PERF_MAX_COUNTERS 1
+
+static struct
+{
+    const char *name;
+} perf_events[PERF_MAX_COUNTERS];
+
+static int  perf_event_index[PERF_MAX_COUNTERS];
+static int  perf_ncounters;
+static char perf_names[1];
+
+int perf_init(void)
+{
+    return 0;
+}
+
+void perf_reset(void)
+{
+}
+
+void perf_start(void)
+{
+}
+
+void perf_stop(double units)
+{
+}
+
+static double read_counter(int i)
+{
+    return -1;
+}
+
+#endif
+
+const char *perf_counter_names(void)
+{
+    return perf_names;
+}
+
+void perf_print(const char *indent, const char *unit)
+{
+    double value;
+    int i, n = 0;
+
+    for (i = 0; i < perf_ncounters; i++)
+    {
+        if ((value = read_counter(i)) < 0)
+            continue;
+        if (n++)
+            printf(", ");
+        else
+            printf("%s[perf: ", indent);
+        printf("%.4g %s/%s", value, perf_events[perf_event_index[i]].name,
+               unit);
+    }
+    if (n)
+        printf("]\n");
+}
+
+void perf_report(const char *test, const char *name, int64_t size,
+                 const char *unit, int hugepage)
+{
+    measurement m;
+    char counter_unit[64];
+    int i;
+
+    for (i = 0; i < perf_ncounters; i++)
+    {
+        if ((m.best = read_counter(i)) < 0)
+            continue;
+        m.median = m.best;
+        m.stddev = 0;
+        snprintf(counter_unit, sizeof(counter_unit), "%s/%s",
+                 perf_events[perf_event_index[i]].name, unit);
+        report_add(test, name, size, 1, &m, counter_unit, hugepage);
+    }
+}
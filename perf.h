@@ -0,0 +1,81 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __PERF_H__
+#define __PERF_H__
+
+#include <stdint.h>
+
+/*
+ * Optional hardware performance counters (cycles, instructions, LLC misses,
+ * dTLB misses, memory requests, ...) read via the linux perf_event_open
+ * syscall. The counters are opened for the calling thread and only count
+ * its user space activity. Typical usage in a benchmark is
+ *
+ *    perf_reset();
+ *    for (each measurement)
+ *    {
+ *        perf_start();
+ *        ... timed code doing 'n' accesses or processing 'n' bytes ...
+ *        perf_stop(n);
+ *    }
+ *    perf_print(" ", "B");
+ *
+ * All the functions do nothing if the counters are not enabled.
+ */
+
+/*
+ * Open all the supported counters. Returns the number of counters which
+ * could be opened (0 if perf_event_open is not available or not permitted,
+ * as is common in containers).
+ */
+int perf_init(void);
+
+/* Comma separated names of the opened counters (for the report header) */
+const char *perf_counter_names(void);
+
+/* Zero the accumulated counts and the number of units of work */
+void perf_reset(void);
+
+/* Start counting */
+void perf_start(void);
+
+/* Stop counting and account for 'units' bytes or accesses of work */
+void perf_stop(double units);
+
+/*
+ * Print the counts accumulated since perf_reset() divided by the number
+ * of units on a separate line, for example
+ *    "<indent>[perf: 1.25 cycles/B, 0.0156 LLC-misses/B]"
+ */
+void perf_print(const char *indent, const char *unit);
+
+/*
+ * Add the counts per unit to the structured report, one record per counter
+ * (with the unit like "LLC-misses/B"), using the same identification of the
+ * test as report_add().
+ */
+void perf_report(const char *test, const char *name, int64_t size,
+                 const char *unit, int hugepage);
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+#include "plugin.h"
+
+#define PLUGIN_MAX_PATH   1024
+#define PLUGIN_MAX_SYMBOL 256
+
+static bench_info plugin_benchmarks[PLUGIN_MAX_FUNCTIONS + 1];
+/* Room for "symbol (library, memcpy)" with the longest accepted names */
+static char       plugin_descriptions[PLUGIN_MAX_FUNCTIONS]
+                                     [PLUGIN_MAX_SYMBOL + PLUGIN_MAX_PATH + 16];
+static int        plugin_count;
+
+#ifndef _WIN32
+
+/*
+ * The standard memcpy and memset signatures differ from the benchmark
+ * kernels, so they are called via the shims. There is one shim per slot,
+ * because the kernel function pointers can't carry any extra state.
+ */
+static void *(*memcpy_impl[PLUGIN_MAX_FUNCTIONS])(void *, const void *, size_t);
+static void *(*memset_impl[PLUGIN_MAX_FUNCTIONS])(void *, int, size_t);
+
+#define SHIMS(n)                                                  \
+static void memcpy_shim##n(int64_t *dst, int64_t *src, int size)  \
+{                                                                 \
+    memcpy_impl[n](dst, src, size);                               \
+}                                                                 \
+static void memset_shim##n(int64_t *dst, int64_t *src, int size)  \
+{                                                                 \
+    memset_impl[n](dst, *(uint8_t *)src, size);                   \
+}
+
+SHIMS(0)  SHIMS(1)  SHIMS(2)  SHIMS(3)
+SHIMS(4)  SHIMS(5)  SHIMS(6)  SHIMS(7)
+SHIMS(8)  SHIMS(9)  SHIMS(10) SHIMS(11)
+SHIMS(12) SHIMS(13) SHIMS(14) SHIMS(15)
+
+static void (*memcpy_shims[PLUGIN_MAX_FUNCTIONS])(int64_t *, int64_t *, int) =
+{
+    memcpy_shim0,  memcpy_shim1,  memcpy_shim2,  memcpy_shim3,
+    memcpy_shim4,  memcpy_shim5,  memcpy_shim6,  memcpy_shim7,
+    memcpy_shim8,  memcpy_shim9,  memcpy_shim10, memcpy_shim11,
+    memcpy_shim12, memcpy_shim13, memcpy_shim14, memcpy_shim15
+};
+
+static void (*memset_shims[PLUGIN_MAX_FUNCTIONS])(int64_t *, int64_t *, int) =
+{
+    memset_shim0,  memset_shim1,  memset_shim2,  memset_shim3,
+    memset_shim4,  memset_shim5,  memset_shim6,  memset_shim7,
+    memset_shim8,  memset_shim9,  memset_shim10, memset_shim11,
+    memset_shim12, memset_shim13, memset_shim14, memset_shim15
+};
+
+/* Register one "name", "memcpy=name" or "memset=name" from the library */
+static int plugin_add(void *lib, const char *libname, const char *symbol)
+{
+    const char *kind = NULL;
+    void *f;
+    int n = plugin_count;
+
+    if (n >= PLUGIN_MAX_FUNCTIONS)
+    {
+        fprintf(stderr, "Too many plugin functions (at most %d)\n",
+                PLUGIN_MAX_FUNCTIONS);
+        return 0;
+    }
+    if (strncmp(symbol, "memcpy=", 7) == 0)
+        kind = "memcpy";
+    else if (strncmp(symbol, "memset=", 7) == 0)
+        kind = "memset";
+    if (kind)
+        symbol += 7;
+    if (!(f = dlsym(lib, symbol)))
+    {
+        fprintf(stderr, "Symbol '%s' not found in '%s'\n", symbol, libname);
+        return 0;
+    }
+
+    if (kind && strcmp(kind, "memcpy") == 0)
+    {
+        *(void **)&memcpy_impl[n] = f;
+        plugin_benchmarks[n].f = memcpy_shims[n];
+    }
+    else if (kind)
+    {
+        *(void **)&memset_impl[n] = f;
+        plugin_benchmarks[n].f = memset_shims[n];
+    }
+    else
+    {
+        *(void **)&plugin_benchmarks[n].f = f;
+    }
+    if (kind)
+        snprintf(plugin_descriptions[n], sizeof(plugin_descriptions[n]),
+                 "%s (%s, %s)", symbol, libname, kind);
+    else
+        snprintf(plugin_descriptions[n], sizeof(plugin_descriptions[n]),
+                 "%s (%s)", symbol, libname);
+    plugin_benchmarks[n].description = plugin_descriptions[n];
+    plugin_benchmarks[n].use_tmpbuf = 0;
+    plugin_count++;
+    return 1;
+}
+
+int plugin_load(const char *spec)
+{
+    char path[PLUGIN_MAX_PATH], symbol[PLUGIN_MAX_SYMBOL];
+    const char *symbols = strrchr(spec, ':'), *end, *libname;
+    void *lib;
+
+    if (!symbols || symbols == spec || !symbols[1] ||
+        symbols - spec >= (int)sizeof(path))
+    {
+        fprintf(stderr, "Expected PATH:SYMBOL[,SYMBOL...] instead of '%s'\n",
+                spec);
+        return 0;
+    }
+    memcpy(path, spec, symbols - spec);
+    path[symbols - spec] = 0;
+    symbols++;
+
+    /* The libraries are never unloaded, the functions are used until exit */
+    if (!(lib = dlopen(path, RTLD_NOW | RTLD_LOCAL)))
+    {
+        fprintf(stderr, "Failed to load '%s': %s\n", path, dlerror());
+        return 0;
+    }
+    libname = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+
+    while (*symbols)
+    {
+        end = strchr(symbols, ',');
+        if (!end)
+            end = symbols + strlen(symbols);
+        if (end - symbols >= (int)sizeof(symbol))
+        {
+            fprintf(stderr, "Symbol name is too long in '%s'\n", spec);
+            return 0;
+        }
+        memcpy(symbol, symbols, end - symbols);
+        symbol[end - symbols] = 0;
+        if (!plugin_add(lib, libname, symbol))
+            return 0;
+        symbols = *end ? end + 1 : end;
+    }
+    return 1;
+}
+
+#else
+
+int plugin_load(const char *spec)
+{
+    fprintf(stderr, "Loading the plugins is not supported on this platform\n");
+    return 0;
+}
+
+#endif
+
+bench_info *get_plugin_benchmarks(void)
+{
+    return plugin_benchmarks;
+}
+
+int plugin_benchmark(const char *description)
+{
+    int i;
+    for (i = 0; i < plugin_count; i++)
+        if (strcmp(plugin_benchmarks[i].description, description) == 0)
+            return 1;
+    return 0;
+}
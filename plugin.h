@@ -0,0 +1,55 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __PLUGIN_H__
+#define __PLUGIN_H__
+
+#include "asm-opt.h"
+
+#define PLUGIN_MAX_FUNCTIONS 16
+
+/*
+ * External copy and fill implementations loaded from shared libraries via
+ * dlopen. The 'spec' has the form "PATH:SYMBOL[,SYMBOL...]", where every
+ * SYMBOL is either
+ *
+ *    name         - a function with the benchmark kernel signature
+ *                   void name(int64_t *dst, int64_t *src, int size)
+ *    memcpy=name  - a function with the standard memcpy signature
+ *    memset=name  - a function with the standard memset signature (called
+ *                   with the first byte of 'src' as the fill value)
+ *
+ * Each function is registered as an extra benchmark with the description
+ * "name (library, memcpy)", "name (library, memset)" or "name (library)".
+ * Returns 1 on success, otherwise prints the error message to stderr and
+ * returns 0.
+ */
+int plugin_load(const char *spec);
+
+/* The benchmarks registered by plugin_load(), terminated by NULL entry */
+bench_info *get_plugin_benchmarks(void);
+
+/* Returns 1 if the benchmark with this description comes from a plugin */
+int plugin_benchmark(const char *description);
+
+#endif
@@ -0,0 +1,585 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/utsname.h>
+#endif
+
+#include "report.h"
+#include "alloc.h"
+#include "timer.h"
+#include "version.h"
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+void measurement_from_samples(measurement *m, const double *samples, int n,
+                              int higher_is_better)
+{
+    double sorted[MAX_SAMPLES];
+    double s1 = 0, s2 = 0;
+    int i;
+
+    if (n > MAX_SAMPLES)
+        n = MAX_SAMPLES;
+    if (n <= 0)
+    {
+        m->best = m->median = m->stddev = 0;
+        return;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        sorted[i] = samples[i];
+        s1 += samples[i];
+        s2 += samples[i] * samples[i];
+    }
+    qsort(sorted, n, sizeof(double), compare_doubles);
+
+    m->best = higher_is_better ? sorted[n - 1] : sorted[0];
+    m->median = n % 2 ? sorted[n / 2] :
+                        (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+    m->stddev = 0;
+    if (n > 1 && n * s2 - s1 * s1 > 0)
+        m->stddev = sqrt((n * s2 - s1 * s1) / (n * (n - 1)));
+}
+
+static int   report_format = REPORT_TEXT;
+static FILE *report_file;
+static int   report_count;
+
+static char  host_cpu_model[128] = "unknown";
+static char  host_kernel[256] = "unknown";
+static char  host_name[128] = "unknown";
+
+static void strip_string(char *s)
+{
+    int n = strlen(s);
+    while (n > 0 && (s[n - 1] == '\n' || s[n - 1] == ' ' || s[n - 1] == '\t'))
+        s[--n] = 0;
+}
+
+static void read_host_metadata(void)
+{
+#ifndef _WIN32
+    struct utsname u;
+    char line[256];
+    FILE *f;
+
+    if (uname(&u) == 0)
+    {
+        snprintf(host_kernel, sizeof(host_kernel), "%s %s", u.sysname,
+                 u.release);
+        snprintf(host_name, sizeof(host_name), "%s", u.nodename);
+    }
+
+    /* x86 has "model name", ARM has "Processor" or "Hardware", MIPS has
+       "cpu model" */
+    f = fopen("/proc/cpuinfo", "r");
+    if (!f)
+        return;
+    while (fgets(line, sizeof(line), f))
+    {
+        char *p = strchr(line, ':');
+        if (!p)
+            continue;
+        if (strncmp(line, "model name", 10) == 0 ||
+            strncmp(line, "Processor", 9) == 0 ||
+            strncmp(line, "cpu model", 9) == 0 ||
+            (strncmp(line, "Hardware", 8) == 0 &&
+             strcmp(host_cpu_model, "unknown") == 0))
+        {
+            p++;
+            while (*p == ' ' || *p == '\t')
+                p++;
+            snprintf(host_cpu_model, sizeof(host_cpu_model), "%s", p);
+            strip_string(host_cpu_model);
+            if (strncmp(line, "Hardware", 8) != 0)
+                break;
+        }
+    }
+    fclose(f);
+#endif
+}
+
+/*
+ * Print a number with 3 decimals, but keep the significant digits of the
+ * small values (such as the performance counter events per byte).
+ */
+static void print_number(double x)
+{
+    fprintf(report_file, x != 0 && fabs(x) < 1 ? "%.6g" : "%.3f", x);
+}
+
+static void print_json_string(const char *s)
+{
+    fputc('"', report_file);
+    for (; *s; s++)
+    {
+        if (*s == '"' || *s == '\\')
+            fprintf(report_file, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20)
+            fprintf(report_file, "\\u%04x", (unsigned char)*s);
+        else
+            fputc(*s, report_file);
+    }
+    fputc('"', report_file);
+}
+
+static void print_csv_string(const char *s)
+{
+    if (!strpbrk(s, ",\"\n"))
+    {
+        fputs(s, report_file);
+        return;
+    }
+    fputc('"', report_file);
+    for (; *s; s++)
+    {
+        if (*s == '"')
+            fputc('"', report_file);
+        fputc(*s, report_file);
+    }
+    fputc('"', report_file);
+}
+
+int report_open(int format, const char *filename)
+{
+    report_format = format;
+    if (format == REPORT_TEXT)
+        return 1;
+
+    if (filename)
+    {
+        report_file = fopen(filename, "w");
+    }
+    else
+    {
+        /* Keep the original stdout for the report, discard everything else */
+        fflush(stdout);
+        report_file = fdopen(dup(fileno(stdout)), "w");
+#ifdef _WIN32
+        freopen("NUL", "w", stdout);
+#else
+        freopen("/dev/null", "w", stdout);
+#endif
+    }
+    if (!report_file)
+    {
+        report_format = REPORT_TEXT;
+        return 0;
+    }
+
+    read_host_metadata();
+    report_count = 0;
+    if (format == REPORT_JSON)
+        fprintf(report_file, "[\n");
+    else
+        fprintf(report_file, "version,hostname,cpu_model,kernel,timer,"
+                "tsc_frequency,test,name,size,threads,best,median,stddev,"
+                "unit,hugepage,cycles,bytes_per_cycle,cpu1,cpu2\n");
+    fflush(report_file);
+    return 1;
+}
+
+/* One result from the baseline and the matching result of this run */
+typedef struct
+{
+    char       *test;
+    char       *name;
+    char       *unit;
+    char       *hugepage;
+    long long   size;
+    int         threads;
+    int         cpu1;
+    int         cpu2;
+    measurement baseline;
+    measurement current;
+    int         matched;
+} compare_record;
+
+static compare_record *compare_records;
+static int             compare_enabled;
+static int             compare_count;
+static int             compare_not_in_baseline;
+static double          compare_threshold;
+
+/*
+ * The direction of the improvement for the unit: 1 if higher is better
+ * (bandwidth, operations per second), -1 if lower is better (latency) or 0
+ * if the results are not compared (the performance counter events, which
+ * have no variance information).
+ */
+static int unit_direction(const char *unit)
+{
+    int n = strlen(unit);
+    if ((n >= 2 && strcmp(unit + n - 2, "/s") == 0) ||
+        strcmp(unit, "fairness") == 0)
+        return 1;
+    if (strcmp(unit, "ns") == 0)
+        return -1;
+    return 0;
+}
+
+static void compare_add(const char *test, const char *name, int64_t size,
+                        int threads, int cpu1, int cpu2, const measurement *m,
+                        const char *unit, const char *hugepage)
+{
+    compare_record *r;
+    int i;
+
+    if (!compare_enabled || unit_direction(unit) == 0)
+        return;
+    for (i = 0; i < compare_count; i++)
+    {
+        r = &compare_records[i];
+        if (!r->matched && r->size == size && r->threads == threads &&
+            r->cpu1 == cpu1 && r->cpu2 == cpu2 &&
+            strcmp(r->test, test) == 0 && strcmp(r->name, name) == 0 &&
+            strcmp(r->unit, unit) == 0 && strcmp(r->hugepage, hugepage) == 0)
+        {
+            r->current = *m;
+            r->matched = 1;
+            return;
+        }
+    }
+    compare_not_in_baseline++;
+}
+
+/* A record with the optional pair of CPUs (-1 if not applicable) */
+static void report_record(const char *test, const char *name, int64_t size,
+                          int threads, int cpu1, int cpu2,
+                          const measurement *m, const char *unit,
+                          int hugepage)
+{
+    const char *hugepage_mode = page_mode_name(hugepage);
+    double hz = timer_cycles_per_second();
+    char cycles[32] = "", bytes_per_cycle[32] = "";
+
+    /* The best result converted to TSC cycles, if the frequency is known */
+    if (hz > 0 && strcmp(unit, "ns") == 0)
+        sprintf(cycles, "%.3f", m->best * hz / 1000000000.);
+    if (hz > 0 && strcmp(unit, "MB/s") == 0)
+        sprintf(bytes_per_cycle, "%.3f", m->best * 1000000. / hz);
+
+    compare_add(test, name, size, threads, cpu1, cpu2, m, unit, hugepage_mode);
+
+    if (report_format == REPORT_JSON)
+    {
+        fprintf(report_file, "%s  {\"version\": ", report_count ? ",\n" : "");
+        print_json_string(VERSION);
+        fprintf(report_file, ", \"hostname\": ");
+        print_json_string(host_name);
+        fprintf(report_file, ", \"cpu_model\": ");
+        print_json_string(host_cpu_model);
+        fprintf(report_file, ", \"kernel\": ");
+        print_json_string(host_kernel);
+        fprintf(report_file, ", \"timer\": ");
+        print_json_string(timer_name());
+        fprintf(report_file, ", \"tsc_frequency\": %.0f", hz);
+        fprintf(report_file, ",\n   \"test\": ");
+        print_json_string(test);
+        fprintf(report_file, ", \"name\": ");
+        print_json_string(name);
+        fprintf(report_file, ", \"size\": %lld, \"threads\": %d,\n",
+                (long long)size, threads);
+        fprintf(report_file, "   \"best\": ");
+        print_number(m->best);
+        fprintf(report_file, ", \"median\": ");
+        print_number(m->median);
+        fprintf(report_file, ", \"stddev\": ");
+        print_number(m->stddev);
+        fprintf(report_file, ", \"unit\": ");
+        print_json_string(unit);
+        fprintf(report_file, ", \"hugepage\": ");
+        print_json_string(hugepage_mode);
+        fprintf(report_file, ",\n   \"cycles\": %s, \"bytes_per_cycle\": %s",
+                *cycles ? cycles : "null",
+                *bytes_per_cycle ? bytes_per_cycle : "null");
+        if (cpu1 >= 0)
+            fprintf(report_file, ", \"cpu1\": %d, \"cpu2\": %d", cpu1, cpu2);
+        fputc('}', report_file);
+    }
+    else if (report_format == REPORT_CSV)
+    {
+        print_csv_string(VERSION);
+        fputc(',', report_file);
+        print_csv_string(host_name);
+        fputc(',', report_file);
+        print_csv_string(host_cpu_model);
+        fputc(',', report_file);
+        print_csv_string(host_kernel);
+        fputc(',', report_file);
+        print_csv_string(timer_name());
+        fprintf(report_file, ",%.0f,", hz);
+        print_csv_string(test);
+        fputc(',', report_file);
+        print_csv_string(name);
+        fprintf(report_file, ",%lld,%d,", (long long)size, threads);
+        print_number(m->best);
+        fputc(',', report_file);
+        print_number(m->median);
+        fputc(',', report_file);
+        print_number(m->stddev);
+        fputc(',', report_file);
+        print_csv_string(unit);
+        fprintf(report_file, ",%s,%s,%s,", hugepage_mode, cycles,
+                bytes_per_cycle);
+        if (cpu1 >= 0)
+            fprintf(report_file, "%d,%d", cpu1, cpu2);
+        else
+            fputc(',', report_file);
+        fputc('\n', report_file);
+    }
+    else
+    {
+        return;
+    }
+    report_count++;
+    fflush(report_file);
+}
+
+void report_add(const char *test, const char *name, int64_t size,
+                int threads, const measurement *m, const char *unit,
+                int hugepage)
+{
+    report_record(test, name, size, threads, -1, -1, m, unit, hugepage);
+}
+
+void report_add_cpu_pair(const char *test, const char *name, int cpu1,
+                         int cpu2, const measurement *m, const char *unit)
+{
+    report_record(test, name, 64, 2, cpu1, cpu2, m, unit, PAGES_DEFAULT);
+}
+
+void report_close(void)
+{
+    if (report_format == REPORT_TEXT)
+        return;
+    if (report_format == REPORT_JSON)
+        fprintf(report_file, "%s]\n", report_count ? "\n" : "");
+    fclose(report_file);
+    report_format = REPORT_TEXT;
+}
+
+static char *copy_string(const char *s)
+{
+    char *p = malloc(strlen(s) + 1);
+    if (p)
+        strcpy(p, s);
+    return p;
+}
+
+/*
+ * Split a CSV line into at most 'maxfields' fields in place, removing the
+ * quotes. Returns the number of the fields.
+ */
+static int split_csv_line(char *line, char **fields, int maxfields)
+{
+    char *src = line, *dst = line;
+    int n = 0;
+
+    strip_string(line);
+    while (n < maxfields)
+    {
+        fields[n++] = dst;
+        if (*src == '"')
+        {
+            src++;
+            while (*src)
+            {
+                if (src[0] == '"' && src[1] == '"')
+                    src++;
+                else if (src[0] == '"')
+                {
+                    src++;
+                    break;
+                }
+                *dst++ = *src++;
+            }
+        }
+        while (*src && *src != ',')
+            *dst++ = *src++;
+        if (*src != ',')
+            break;
+        src++;
+        *dst++ = 0;
+    }
+    *dst = 0;
+    return n;
+}
+
+#define CSV_MAX_FIELDS 32
+
+int report_compare_open(const char *filename, double threshold)
+{
+    static const char *columns[] =
+    {
+        "test", "name", "size", "threads", "best", "median", "stddev",
+        "unit", "hugepage", NULL
+    };
+    enum { TEST, NAME, SIZE, THREADS, BEST, MEDIAN, STDDEV, UNIT, HUGEPAGE };
+    char line[4096], *fields[CSV_MAX_FIELDS];
+    int index[9], cpu1_index = -1, cpu2_index = -1;
+    int i, j, n, nfields, allocated = 0;
+    compare_record *r;
+    FILE *f = fopen(filename, "r");
+
+    if (!f)
+        return 0;
+    /* Find the columns by the names in the header */
+    if (!fgets(line, sizeof(line), f))
+    {
+        fclose(f);
+        return 0;
+    }
+    nfields = split_csv_line(line, fields, CSV_MAX_FIELDS);
+    for (i = 0; columns[i]; i++)
+    {
+        for (j = 0; j < nfields && strcmp(fields[j], columns[i]) != 0; j++)
+            ;
+        if (j == nfields)
+        {
+            fclose(f);
+            return 0;
+        }
+        index[i] = j;
+    }
+    /* The CPU pair columns are missing in the older reports */
+    for (j = 0; j < nfields; j++)
+    {
+        if (strcmp(fields[j], "cpu1") == 0)
+            cpu1_index = j;
+        if (strcmp(fields[j], "cpu2") == 0)
+            cpu2_index = j;
+    }
+
+    /* A baseline with only the header is valid, nothing is matched then */
+    compare_enabled = 1;
+    compare_threshold = threshold;
+    compare_count = 0;
+    while (fgets(line, sizeof(line), f))
+    {
+        if ((n = split_csv_line(line, fields, CSV_MAX_FIELDS)) < nfields)
+            continue;
+        if (compare_count == allocated)
+        {
+            allocated = allocated ? allocated * 2 : 256;
+            r = realloc(compare_records, allocated * sizeof(compare_record));
+            if (!r)
+                break;
+            compare_records = r;
+        }
+        r = &compare_records[compare_count];
+        memset(r, 0, sizeof(*r));
+        r->test = copy_string(fields[index[TEST]]);
+        r->name = copy_string(fields[index[NAME]]);
+        r->unit = copy_string(fields[index[UNIT]]);
+        r->hugepage = copy_string(fields[index[HUGEPAGE]]);
+        if (!r->test || !r->name || !r->unit || !r->hugepage)
+            break;
+        r->size = atoll(fields[index[SIZE]]);
+        r->threads = atoi(fields[index[THREADS]]);
+        r->cpu1 = cpu1_index >= 0 && *fields[cpu1_index] ?
+                  atoi(fields[cpu1_index]) : -1;
+        r->cpu2 = cpu2_index >= 0 && *fields[cpu2_index] ?
+                  atoi(fields[cpu2_index]) : -1;
+        r->baseline.best = atof(fields[index[BEST]]);
+        r->baseline.median = atof(fields[index[MEDIAN]]);
+        r->baseline.stddev = atof(fields[index[STDDEV]]);
+        compare_count++;
+    }
+    fclose(f);
+    return 1;
+}
+
+int report_compare_summary(FILE *f)
+{
+    int i, direction, ncompared = 0, nregressions = 0, nimprovements = 0;
+    int nmissing = 0;
+    double delta, sigma;
+    compare_record *r;
+    const char *mark;
+
+    fprintf(f, "\n %8s : %12s -> %-12s %-11s : test, name (size, threads)\n",
+            "delta", "baseline", "current", "unit");
+    for (i = 0; i < compare_count; i++)
+    {
+        r = &compare_records[i];
+        if (!r->matched)
+        {
+            if (unit_direction(r->unit) != 0)
+                nmissing++;
+            continue;
+        }
+        ncompared++;
+        direction = unit_direction(r->unit);
+        delta = r->baseline.best != 0 ?
+                (r->current.best - r->baseline.best) / r->baseline.best * 100 :
+                0;
+        sigma = sqrt(r->baseline.stddev * r->baseline.stddev +
+                     r->current.stddev * r->current.stddev);
+        mark = "";
+        /* Only the differences beyond the noise of both runs are counted */
+        if (fabs(delta) > compare_threshold &&
+            fabs(r->current.best - r->baseline.best) > 2 * sigma)
+        {
+            if (delta * direction < 0)
+            {
+                mark = " << REGRESSION";
+                nregressions++;
+            }
+            else
+            {
+                mark = " (improved)";
+                nimprovements++;
+            }
+        }
+        fprintf(f, " %+7.1f%% : %12.6g -> %-12.6g %-11s : %s, %s", delta,
+                r->baseline.best, r->current.best, r->unit, r->test, r->name);
+        if (r->cpu1 >= 0)
+            fprintf(f, ", cpu %d, cpu %d", r->cpu1, r->cpu2);
+        fprintf(f, " (%lld, %d)%s\n", r->size, r->threads, mark);
+    }
+    fprintf(f, "\n %d results compared, %d regressions, %d improvements "
+            "(threshold %.1f%%)\n", ncompared, nregressions, nimprovements,
+            compare_threshold);
+    if (compare_not_in_baseline)
+        fprintf(f, " %d results are not in the baseline\n",
+                compare_not_in_baseline);
+    if (nmissing)
+        fprintf(f, " %d baseline results were not measured in this run\n",
+                nmissing);
+    return nregressions;
+}
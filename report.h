@@ -0,0 +1,103 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __REPORT_H__
+#define __REPORT_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* The largest number of samples accepted by measurement_from_samples */
+#define MAX_SAMPLES 256
+
+/* Summary of the repeated measurements of the same quantity */
+typedef struct
+{
+    double best;
+    double median;
+    double stddev;
+} measurement;
+
+/*
+ * Fill 'm' from 'n' samples. The best value is the maximum if
+ * 'higher_is_better' is nonzero (bandwidth) or the minimum otherwise
+ * (latency).
+ */
+void measurement_from_samples(measurement *m, const double *samples, int n,
+                              int higher_is_better);
+
+enum
+{
+    REPORT_TEXT,
+    REPORT_JSON,
+    REPORT_CSV
+};
+
+/*
+ * Start writing the structured report in the given format to 'filename'.
+ * If 'filename' is NULL, the report goes to stdout and the human-readable
+ * output is suppressed. Nothing is done for REPORT_TEXT. Returns 0 on
+ * failure.
+ */
+int report_open(int format, const char *filename);
+
+/*
+ * Add a record to the structured report. 'test' is the name of the test
+ * group, 'name' identifies the benchmark within the group. 'hugepage' is
+ * the page mode of the buffers (see alloc.h). If the TSC frequency is known,
+ * the results in "ns" are also reported in cycles and the results in "MB/s"
+ * in bytes per cycle.
+ */
+void report_add(const char *test, const char *name, int64_t size,
+                int threads, const measurement *m, const char *unit,
+                int hugepage);
+
+/*
+ * Add a record for a pair of CPUs (such as the core-to-core latency), with
+ * the CPU numbers in the separate "cpu1" and "cpu2" fields. Each unordered
+ * pair is expected to be added only once, with 'cpu1' < 'cpu2'.
+ */
+void report_add_cpu_pair(const char *test, const char *name, int cpu1,
+                         int cpu2, const measurement *m, const char *unit);
+
+/* Finish the structured report */
+void report_close(void);
+
+/*
+ * Load the baseline results from a CSV report (as written with --format=csv)
+ * and compare every following report_add() record with it. The records are
+ * matched by the test, name, size, number of threads, unit and page mode.
+ * A difference is a regression if the result is worse by more than
+ * 'threshold' percent and also by more than twice the combined standard
+ * deviation of both runs. A baseline with only the header line is valid
+ * and matches nothing. Returns 0 on failure.
+ */
+int report_compare_open(const char *filename, double threshold);
+
+/*
+ * Print the relative differences from the baseline for all the matched
+ * records to 'f'. Returns the number of the regressions.
+ */
+int report_compare_summary(FILE *f);
+
+#endif
@@ -0,0 +1,193 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "threads.h"
+
+void spin_barrier_init(spin_barrier_t *barrier, int nthreads)
+{
+    barrier->count = 0;
+    barrier->generation = 0;
+    barrier->nthreads = nthreads;
+}
+
+void spin_barrier_wait(spin_barrier_t *barrier)
+{
+    int generation = barrier->generation;
+    if (__sync_add_and_fetch(&barrier->count, 1) == barrier->nthreads)
+    {
+        barrier->count = 0;
+        __sync_synchronize();
+        barrier->generation = generation + 1;
+        return;
+    }
+    while (barrier->generation == generation)
+    {
+#ifndef _WIN32
+        /* Don't waste the whole timeslice if the CPUs are oversubscribed */
+        sched_yield();
+#endif
+    }
+    __sync_synchronize();
+}
+
+#ifdef __linux__
+
+int get_cpu_list(int *cpus, int maxcpus)
+{
+    cpu_set_t set;
+    int cpu, n = 0;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+    {
+        cpus[0] = 0;
+        return 1;
+    }
+    for (cpu = 0; cpu < CPU_SETSIZE && n < maxcpus; cpu++)
+        if (CPU_ISSET(cpu, &set))
+            cpus[n++] = cpu;
+    if (n == 0)
+        cpus[n++] = 0;
+    return n;
+}
+
+int bind_current_thread_to_cpu(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+#else
+
+int get_cpu_list(int *cpus, int maxcpus)
+{
+    cpus[0] = 0;
+    return 1;
+}
+
+int bind_current_thread_to_cpu(int cpu)
+{
+    return 0;
+}
+
+#endif
+
+typedef struct
+{
+    int          thread_index;
+    int          cpu;
+    thread_func  func;
+    void        *arg;
+    volatile int *gate;
+} thread_start_info;
+
+#ifndef _WIN32
+
+static void *thread_start(void *arg)
+{
+    thread_start_info *info = (thread_start_info *)arg;
+    /*
+     * Wait until all the threads are created, because 'func' usually
+     * waits for the others on a barrier. Don't start at all if some
+     * thread could not be created.
+     */
+    while (*info->gate == 0)
+        sched_yield();
+    __sync_synchronize();
+    if (*info->gate < 0)
+        return NULL;
+    if (info->cpu >= 0)
+        bind_current_thread_to_cpu(info->cpu);
+    info->func(info->thread_index, info->cpu, info->arg);
+    return NULL;
+}
+
+int run_threads(int nthreads, const int *cpus, int ncpus,
+                thread_func func, void *arg)
+{
+    pthread_t *threads;
+    thread_start_info *info;
+    volatile int gate = 0;
+    int i, created, result = 1;
+
+    threads = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+    info = (thread_start_info *)malloc(nthreads * sizeof(thread_start_info));
+    if (!threads || !info)
+    {
+        free(threads);
+        free(info);
+        return 0;
+    }
+
+    for (i = 0; i < nthreads; i++)
+    {
+        info[i].thread_index = i;
+        info[i].cpu = cpus ? cpus[i % ncpus] : -1;
+        info[i].func = func;
+        info[i].arg = arg;
+        info[i].gate = &gate;
+    }
+
+    for (created = 0; created < nthreads; created++)
+    {
+        if (pthread_create(&threads[created], NULL, thread_start,
+                           &info[created]) != 0)
+        {
+            result = 0;
+            break;
+        }
+    }
+    __sync_synchronize();
+    gate = result ? 1 : -1;
+    for (i = 0; i < created; i++)
+        pthread_join(threads[i], NULL);
+
+    free(threads);
+    free(info);
+    return result;
+}
+
+#else
+
+int run_threads(int nthreads, const int *cpus, int ncpus,
+                thread_func func, void *arg)
+{
+    /* No threads support, but a single thread can still run */
+    if (nthreads != 1)
+        return 0;
+    func(0, cpus ? cpus[0] : -1, arg);
+    return 1;
+}
+
+#endif
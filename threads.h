@@ -0,0 +1,64 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __THREADS_H__
+#define __THREADS_H__
+
+#define MAX_CPUS 1024
+
+/*
+ * A tiny spinning barrier. Threads which are released from it start
+ * running at almost the same time, which is important when we want
+ * to measure the aggregate memory bandwidth of several CPU cores.
+ */
+typedef struct
+{
+    volatile int count;
+    volatile int generation;
+    int          nthreads;
+} spin_barrier_t;
+
+void spin_barrier_init(spin_barrier_t *barrier, int nthreads);
+void spin_barrier_wait(spin_barrier_t *barrier);
+
+/*
+ * Fill the 'cpus' array with the numbers of the CPUs, which are allowed
+ * to be used by this process. Returns the number of CPUs (at least 1).
+ */
+int get_cpu_list(int *cpus, int maxcpus);
+
+/* Bind the calling thread to the specified CPU. Returns 1 on success */
+int bind_current_thread_to_cpu(int cpu);
+
+typedef void (*thread_func)(int thread_index, int cpu, void *arg);
+
+/*
+ * Run 'nthreads' instances of 'func' in parallel and wait for all of them
+ * to finish. Each thread gets bound to cpus[thread_index % ncpus] before
+ * calling 'func' (or not bound at all if 'cpus' is NULL). Returns 1 on
+ * success and 0 if the threads could not be created.
+ */
+int run_threads(int nthreads, const int *cpus, int ncpus,
+                thread_func func, void *arg);
+
+#endif
@@ -0,0 +1,230 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#if defined(__i386__) || defined(__amd64__)
+#include <cpuid.h>
+#endif
+
+#include "timer.h"
+
+static double gettime_gettimeofday(void)
+{
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+    return (double)((int64_t)tv.tv_sec * 1000000 + tv.tv_usec) / 1000000.;
+}
+
+#if defined(CLOCK_MONOTONIC_RAW)
+# define MONOTONIC_CLOCK_ID CLOCK_MONOTONIC_RAW
+#elif defined(CLOCK_MONOTONIC)
+# define MONOTONIC_CLOCK_ID CLOCK_MONOTONIC
+#endif
+
+static int monotonic_available(void)
+{
+#ifdef MONOTONIC_CLOCK_ID
+    struct timespec ts;
+    return clock_gettime(MONOTONIC_CLOCK_ID, &ts) == 0;
+#else
+    return 0;
+#endif
+}
+
+static double gettime_monotonic(void)
+{
+#ifdef MONOTONIC_CLOCK_ID
+    struct timespec ts;
+    clock_gettime(MONOTONIC_CLOCK_ID, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1000000000.;
+#else
+    return gettime_gettimeofday();
+#endif
+}
+
+/* TSC frequency in Hz (0 if there is no usable invariant TSC) */
+static double   tsc_frequency;
+static uint64_t tsc_base;
+static int      tsc_has_rdtscp;
+
+#if defined(__i386__) || defined(__amd64__)
+
+static inline uint64_t read_tsc(void)
+{
+    uint32_t lo, hi;
+    if (tsc_has_rdtscp)
+        __asm__ volatile ("rdtscp" : "=a" (lo), "=d" (hi) : : "ecx", "memory");
+    else
+        __asm__ volatile ("lfence\n rdtsc" : "=a" (lo), "=d" (hi) : : "memory");
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/*
+ * Find the TSC frequency by comparing it with the monotonic clock over
+ * a 50 ms interval (the median of 3 attempts is used).
+ */
+static double calibrate_tsc(void)
+{
+    double t0, t1, f[3], tmp;
+    uint64_t c0, c1;
+    int i, j;
+
+    for (i = 0; i < 3; i++)
+    {
+        t0 = gettime_monotonic();
+        c0 = read_tsc();
+        do
+        {
+            t1 = gettime_monotonic();
+            c1 = read_tsc();
+        } while (t1 - t0 < 0.05);
+        f[i] = (double)(c1 - c0) / (t1 - t0);
+    }
+    for (i = 0; i < 3; i++)
+        for (j = i + 1; j < 3; j++)
+            if (f[j] < f[i])
+            {
+                tmp = f[i];
+                f[i] = f[j];
+                f[j] = tmp;
+            }
+    return f[1];
+}
+
+static void init_tsc(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    /* Invariant TSC: CPUID.80000007H:EDX[8] */
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) ||
+        !(edx & (1 << 8)) || !monotonic_available())
+        return;
+    /* RDTSCP: CPUID.80000001H:EDX[27] */
+    if (__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) && (edx & (1 << 27)))
+        tsc_has_rdtscp = 1;
+
+    tsc_frequency = calibrate_tsc();
+    tsc_base = read_tsc();
+}
+
+static double gettime_tsc(void)
+{
+    return (double)(read_tsc() - tsc_base) / tsc_frequency;
+}
+
+#else
+
+static void init_tsc(void)
+{
+}
+
+static double gettime_tsc(void)
+{
+    return 0;
+}
+
+#endif
+
+static struct
+{
+    const char *name;
+    double    (*gettime)(void);
+} timers[] =
+{
+    { "monotonic",    gettime_monotonic },
+    { "tsc",          gettime_tsc },
+    { "gettimeofday", gettime_gettimeofday },
+    { NULL, NULL }
+};
+
+static int    timer_initialized;
+static int    timer_index = 2;
+static double timer_res;
+
+/* The smallest nonzero difference between two consecutive readings */
+static double measure_resolution(void)
+{
+    double t0, t1, res = 1;
+    int i;
+
+    for (i = 0; i < 100; i++)
+    {
+        t0 = timers[timer_index].gettime();
+        while ((t1 = timers[timer_index].gettime()) == t0) {}
+        if (t1 - t0 < res)
+            res = t1 - t0;
+    }
+    return res;
+}
+
+int timer_init(const char *name)
+{
+    int i;
+
+    if (!timer_initialized)
+    {
+        init_tsc();
+        timer_initialized = 1;
+    }
+
+    if (!name)
+        name = monotonic_available() ? "monotonic" : "gettimeofday";
+
+    for (i = 0; timers[i].name; i++)
+    {
+        if (strcmp(timers[i].name, name) != 0)
+            continue;
+        if (strcmp(name, "monotonic") == 0 && !monotonic_available())
+            return 0;
+        if (strcmp(name, "tsc") == 0 && tsc_frequency == 0)
+            return 0;
+        timer_index = i;
+        timer_res = measure_resolution();
+        return 1;
+    }
+    return 0;
+}
+
+const char *timer_name(void)
+{
+    return timers[timer_index].name;
+}
+
+double gettime(void)
+{
+    return timers[timer_index].gettime();
+}
+
+double timer_resolution(void)
+{
+    return timer_res;
+}
+
+double timer_cycles_per_second(void)
+{
+    return tsc_frequency;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+/*
+ * Select the timer backend by name or the default one (if 'name' is NULL).
+ * The available backends are:
+ *    monotonic    - clock_gettime(CLOCK_MONOTONIC_RAW), the default
+ *    tsc          - invariant TSC read by RDTSCP (x86 only), calibrated
+ *                   against the monotonic clock
+ *    gettimeofday - the portable fallback
+ * Returns 0 if the backend is not available.
+ */
+int timer_init(const char *name);
+
+/* The name of the selected timer backend */
+const char *timer_name(void);
+
+/* The current time in seconds */
+double gettime(void);
+
+/* The measured resolution of the selected timer in seconds */
+double timer_resolution(void);
+
+/*
+ * The frequency of the invariant TSC in Hz (0 if unknown). This is used to
+ * report the results in cycles. Note that on the CPUs with dynamic frequency
+ * scaling the TSC frequency may differ from the actual core frequency.
+ */
+double timer_cycles_per_second(void);
+
+#endif
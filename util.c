@@ -22,11 +22,13 @@
  */
 
 #include <string.h>
+#include <ctype.h>
 #include <stdint.h>
 #include <stdlib.h>
-#include <sys/time.h>
 
 #include "util.h"
+#include "alloc.h"
+#include "asm-opt.h"
 
 void aligned_block_copy(int64_t * __restrict dst_,
                         int64_t * __restrict src,
@@ -211,6 +213,314 @@ void aligned_block_copy_pf64(int64_t * __restrict dst_,
     }
 }
 
+/*
+ * The read benchmarks sum the loaded data and store the result to this
+ * variable, so that the compiler can't optimize the memory accesses away.
+ * The variants with 2 and 4 data streams split the 'size' bytes between
+ * the beginning of the 'src' and 'dst' buffers (and their middle points).
+ */
+static volatile int64_t read_sink;
+
+void aligned_block_read(int64_t * __restrict dst,
+                        int64_t * __restrict src,
+                        int                  size)
+{
+    int64_t t1 = 0, t2 = 0, t3 = 0, t4 = 0;
+    while ((size -= 64) >= 0)
+    {
+        t1 += *src++;
+        t2 += *src++;
+        t3 += *src++;
+        t4 += *src++;
+        t1 += *src++;
+        t2 += *src++;
+        t3 += *src++;
+        t4 += *src++;
+    }
+    read_sink = t1 + t2 + t3 + t4;
+}
+
+void aligned_block_read_pf32(int64_t * __restrict dst,
+                             int64_t * __restrict src,
+                             int                  size)
+{
+    int64_t t1 = 0, t2 = 0, t3 = 0, t4 = 0;
+    while ((size -= 64) >= 0)
+    {
+        __builtin_prefetch(src + 32, 0, 0);
+        t1 += *src++;
+        t2 += *src++;
+        t3 += *src++;
+        t4 += *src++;
+        __builtin_prefetch(src + 32, 0, 0);
+        t1 += *src++;
+        t2 += *src++;
+        t3 += *src++;
+        t4 += *src++;
+    }
+    read_sink = t1 + t2 + t3 + t4;
+}
+
+void aligned_block_read_pf64(int64_t * __restrict dst,
+                             int64_t * __restrict src,
+                             int                  size)
+{
+    int64_t t1 = 0, t2 = 0, t3 = 0, t4 = 0;
+    while ((size -= 64) >= 0)
+    {
+        __builtin_prefetch(src + 32, 0, 0);
+        t1 += *src++;
+        t2 += *src++;
+        t3 += *src++;
+        t4 += *src++;
+        t1 += *src++;
+        t2 += *src++;
+        t3 += *src++;
+        t4 += *src++;
+    }
+    read_sink = t1 + t2 + t3 + t4;
+}
+
+void aligned_block_read2(int64_t * __restrict dst,
+                         int64_t * __restrict src,
+                         int                  size)
+{
+    int64_t t1 = 0, t2 = 0, t3 = 0, t4 = 0;
+    while ((size -= 128) >= 0)
+    {
+        t1 += *src++;
+        t2 += *dst++;
+        t3 += *src++;
+        t4 += *dst++;
+        t1 += *src++;
+        t2 += *dst++;
+        t3 += *src++;
+        t4 += *dst++;
+        t1 += *src++;
+        t2 += *dst++;
+        t3 += *src++;
+        t4 += *dst++;
+        t1 += *src++;
+        t2 += *dst++;
+        t3 += *src++;
+        t4 += *dst++;
+    }
+    read_sink = t1 + t2 + t3 + t4;
+}
+
+void aligned_block_read2_pf32(int64_t * __restrict dst,
+                              int64_t * __restrict src,
+                              int                  size)
+{
+    int64_t t1 = 0, t2 = 0, t3 = 0, t4 = 0;
+    while ((size -= 128) >= 0)
+    {
+        __builtin_prefetch(src + 32, 0, 0);
+        __builtin_prefetch(dst + 32, 0, 0);
+        t1 += *src++;
+        t2 += *dst++;
+        t3 += *src++;
+        t4 += *dst++;
+        t1 += *src++;
+        t2 += *dst++;
+        t3 += *src++;
+        t4 += *dst++;
+        __builtin_prefetch(src + 32, 0, 0);
+        __builtin_prefetch(dst + 32, 0, 0);
+        t1 += *src++;
+        t2 += *dst++;
+        t3 += *src++;
+        t4 += *dst++;
+        t1 += *src++;
+        t2 += *dst++;
+        t3 += *src++;
+        t4 += *dst++;
+    }
+    read_sink = t1 + t2 + t3 + t4;
+}
+
+void aligned_block_read2_pf64(int64_t * __restrict dst,
+                              int64_t * __restrict src,
+                              int                  size)
+{
+    int64_t t1 = 0, t2 = 0, t3 = 0, t4 = 0;
+    while ((size -= 128) >= 0)
+    {
+        __builtin_prefetch(src + 32, 0, 0);
+        __builtin_prefetch(dst + 32, 0, 0);
+        t1 += *src++;
+        t2 += *dst++;
+        t3 += *src++;
+        t4 += *dst++;
+        t1 += *src++;
+        t2 += *dst++;
+        t3 += *src++;
+        t4 += *dst++;
+        t1 += *src++;
+        t2 += *dst++;
+        t3 += *src++;
+        t4 += *dst++;
+        t1 += *src++;
+        t2 += *dst++;
+        t3 += *src++;
+        t4 += *dst++;
+    }
+    read_sink = t1 + t2 + t3 + t4;
+}
+
+void aligned_block_read4(int64_t * __restrict dst,
+                         int64_t * __restrict src,
+                         int                  size)
+{
+    int64_t t1 = 0, t2 = 0, t3 = 0, t4 = 0;
+    int64_t *src2, *dst2;
+    size &= ~255;
+    src2 = src + size / 32;
+    dst2 = dst + size / 32;
+    while ((size -= 256) >= 0)
+    {
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+    }
+    read_sink = t1 + t2 + t3 + t4;
+}
+
+void aligned_block_read4_pf32(int64_t * __restrict dst,
+                              int64_t * __restrict src,
+                              int                  size)
+{
+    int64_t t1 = 0, t2 = 0, t3 = 0, t4 = 0;
+    int64_t *src2, *dst2;
+    size &= ~255;
+    src2 = src + size / 32;
+    dst2 = dst + size / 32;
+    while ((size -= 256) >= 0)
+    {
+        __builtin_prefetch(src + 32, 0, 0);
+        __builtin_prefetch(src2 + 32, 0, 0);
+        __builtin_prefetch(dst + 32, 0, 0);
+        __builtin_prefetch(dst2 + 32, 0, 0);
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        __builtin_prefetch(src + 32, 0, 0);
+        __builtin_prefetch(src2 + 32, 0, 0);
+        __builtin_prefetch(dst + 32, 0, 0);
+        __builtin_prefetch(dst2 + 32, 0, 0);
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+    }
+    read_sink = t1 + t2 + t3 + t4;
+}
+
+void aligned_block_read4_pf64(int64_t * __restrict dst,
+                              int64_t * __restrict src,
+                              int                  size)
+{
+    int64_t t1 = 0, t2 = 0, t3 = 0, t4 = 0;
+    int64_t *src2, *dst2;
+    size &= ~255;
+    src2 = src + size / 32;
+    dst2 = dst + size / 32;
+    while ((size -= 256) >= 0)
+    {
+        __builtin_prefetch(src + 32, 0, 0);
+        __builtin_prefetch(src2 + 32, 0, 0);
+        __builtin_prefetch(dst + 32, 0, 0);
+        __builtin_prefetch(dst2 + 32, 0, 0);
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+        t1 += *src++;
+        t2 += *src2++;
+        t3 += *dst++;
+        t4 += *dst2++;
+    }
+    read_sink = t1 + t2 + t3 + t4;
+}
+
 void aligned_block_fill(int64_t * __restrict dst_,
                         int64_t * __restrict src,
                         int                  size)
@@ -296,11 +606,246 @@ void aligned_block_fill_shuffle64(int64_t * __restrict dst_,
     }
 }
 
-double gettime(void)
+/*
+ * Streaming with the given ratio of the read and written bytes: every step
+ * reads 'reads' cache lines from the source buffer, combines them and writes
+ * the result to 'writes' cache lines of the destination buffer. The 'size'
+ * is the total number of the read and written bytes.
+ */
+static inline void aligned_block_rw(int64_t * __restrict dst_,
+                                    int64_t * __restrict src,
+                                    int                  size,
+                                    int                  reads,
+                                    int                  writes)
 {
-    struct timeval tv;
-    gettimeofday (&tv, NULL);
-    return (double)((int64_t)tv.tv_sec * 1000000 + tv.tv_usec) / 1000000.;
+    volatile int64_t *dst = dst_;
+    int64_t t[8];
+    int i, j;
+    while ((size -= (reads + writes) * 64) >= 0)
+    {
+        for (i = 0; i < 8; i++)
+            t[i] = *src++;
+        for (j = 1; j < reads; j++)
+            for (i = 0; i < 8; i++)
+                t[i] ^= *src++;
+        for (j = 0; j < writes; j++)
+            for (i = 0; i < 8; i++)
+                *dst++ = t[i];
+    }
+}
+
+void aligned_block_rw31(int64_t * __restrict dst,
+                        int64_t * __restrict src,
+                        int                  size)
+{
+    aligned_block_rw(dst, src, size, 3, 1);
+}
+
+void aligned_block_rw21(int64_t * __restrict dst,
+                        int64_t * __restrict src,
+                        int                  size)
+{
+    aligned_block_rw(dst, src, size, 2, 1);
+}
+
+void aligned_block_rw11(int64_t * __restrict dst,
+                        int64_t * __restrict src,
+                        int                  size)
+{
+    aligned_block_rw(dst, src, size, 1, 1);
+}
+
+void aligned_block_rw12(int64_t * __restrict dst,
+                        int64_t * __restrict src,
+                        int                  size)
+{
+    aligned_block_rw(dst, src, size, 1, 2);
+}
+
+/*
+ * Prefetching read and copy with the distance set by set_prefetch_distance()
+ * and the locality hint of __builtin_prefetch() (0 = nontemporal, such as
+ * PREFETCHNTA or PLDL1STRM, ... 3 = keep in all the cache levels, such as
+ * PREFETCHT0 or PLDL1KEEP). The checks of 'locality' are folded after
+ * inlining.
+ */
+static int prefetch_distance = 256;
+
+void set_prefetch_distance(int distance)
+{
+    prefetch_distance = distance;
+}
+
+/*
+ * A macro rather than a function, because GCC considers a function with
+ * nothing but prefetches in it to have no effect and removes the calls.
+ */
+#define PREFETCH_WITH_LOCALITY(p, locality)                                  \
+    do                                                                       \
+    {                                                                        \
+        if ((locality) == 0)                                                 \
+            __builtin_prefetch(p, 0, 0);                                     \
+        else if ((locality) == 1)                                            \
+            __builtin_prefetch(p, 0, 1);                                     \
+        else if ((locality) == 2)                                            \
+            __builtin_prefetch(p, 0, 2);                                     \
+        else                                                                 \
+            __builtin_prefetch(p, 0, 3);                                     \
+    } while (0)
+
+static inline void aligned_block_read_pfdist(int64_t * __restrict src,
+                                             int                  size,
+                                             int                  locality)
+{
+    int distance = prefetch_distance / sizeof(int64_t);
+    int64_t t1 = 0, t2 = 0, t3 = 0, t4 = 0;
+    while ((size -= 64) >= 0)
+    {
+        PREFETCH_WITH_LOCALITY(src + distance, locality);
+        t1 += *src++;
+        t2 += *src++;
+        t3 += *src++;
+        t4 += *src++;
+        t1 += *src++;
+        t2 += *src++;
+        t3 += *src++;
+        t4 += *src++;
+    }
+    read_sink = t1 + t2 + t3 + t4;
+}
+
+static inline void aligned_block_copy_pfdist(int64_t * __restrict dst_,
+                                             int64_t * __restrict src,
+                                             int                  size,
+                                             int                  locality)
+{
+    volatile int64_t *dst = dst_;
+    int distance = prefetch_distance / sizeof(int64_t);
+    int64_t t1, t2, t3, t4;
+    while ((size -= 64) >= 0)
+    {
+        PREFETCH_WITH_LOCALITY(src + distance, locality);
+        t1 = *src++;
+        t2 = *src++;
+        t3 = *src++;
+        t4 = *src++;
+        *dst++ = t1;
+        *dst++ = t2;
+        *dst++ = t3;
+        *dst++ = t4;
+        t1 = *src++;
+        t2 = *src++;
+        t3 = *src++;
+        t4 = *src++;
+        *dst++ = t1;
+        *dst++ = t2;
+        *dst++ = t3;
+        *dst++ = t4;
+    }
+}
+
+void aligned_block_read_pfdist0(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size)
+{
+    aligned_block_read_pfdist(src, size, 0);
+}
+
+void aligned_block_read_pfdist1(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size)
+{
+    aligned_block_read_pfdist(src, size, 1);
+}
+
+void aligned_block_read_pfdist2(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size)
+{
+    aligned_block_read_pfdist(src, size, 2);
+}
+
+void aligned_block_read_pfdist3(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size)
+{
+    aligned_block_read_pfdist(src, size, 3);
+}
+
+void aligned_block_copy_pfdist0(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size)
+{
+    aligned_block_copy_pfdist(dst, src, size, 0);
+}
+
+void aligned_block_copy_pfdist1(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size)
+{
+    aligned_block_copy_pfdist(dst, src, size, 1);
+}
+
+void aligned_block_copy_pfdist2(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size)
+{
+    aligned_block_copy_pfdist(dst, src, size, 2);
+}
+
+void aligned_block_copy_pfdist3(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size)
+{
+    aligned_block_copy_pfdist(dst, src, size, 3);
+}
+
+/*
+ * Scalar STREAM kernels (see asm-opt.h), the stores are volatile to keep
+ * the compiler from vectorizing the loops or turning them into memcpy.
+ */
+void stream_copy(double * __restrict dst_,
+                 double * __restrict src1,
+                 double * __restrict src2,
+                 int                 size)
+{
+    volatile double *dst = dst_;
+    int i, n = size / sizeof(double);
+    for (i = 0; i < n; i++)
+        dst[i] = src1[i];
+}
+
+void stream_scale(double * __restrict dst_,
+                  double * __restrict src1,
+                  double * __restrict src2,
+                  int                 size)
+{
+    volatile double *dst = dst_;
+    int i, n = size / sizeof(double);
+    for (i = 0; i < n; i++)
+        dst[i] = STREAM_SCALAR * src1[i];
+}
+
+void stream_add(double * __restrict dst_,
+                double * __restrict src1,
+                double * __restrict src2,
+                int                 size)
+{
+    volatile double *dst = dst_;
+    int i, n = size / sizeof(double);
+    for (i = 0; i < n; i++)
+        dst[i] = src1[i] + src2[i];
+}
+
+void stream_triad(double * __restrict dst_,
+                  double * __restrict src1,
+                  double * __restrict src2,
+                  int                 size)
+{
+    volatile double *dst = dst_;
+    int i, n = size / sizeof(double);
+    for (i = 0; i < n; i++)
+        dst[i] = src1[i] + STREAM_SCALAR * src2[i];
 }
 
 double fmin(double a, double b)
@@ -308,6 +853,56 @@ double fmin(double a, double b)
     return a < b ? a : b;
 }
 
+int glob_match(const char *pattern, const char *s)
+{
+    while (*pattern)
+    {
+        if (*pattern == '*')
+        {
+            while (*pattern == '*')
+                pattern++;
+            if (!*pattern)
+                return 1;
+            for (; *s; s++)
+                if (glob_match(pattern, s))
+                    return 1;
+            return 0;
+        }
+        if (!*s || (*pattern != '?' &&
+                    tolower((unsigned char)*pattern) !=
+                    tolower((unsigned char)*s)))
+            return 0;
+        pattern++;
+        s++;
+    }
+    return !*s;
+}
+
+int64_t parse_size(const char *s)
+{
+    char *end;
+    double size = strtod(s, &end);
+
+    if (end == s || size < 0)
+        return -1;
+    switch (tolower((unsigned char)*end))
+    {
+        case 'g': size *= 1024; /* fall through */
+        case 'm': size *= 1024; /* fall through */
+        case 'k': size *= 1024;
+            end++;
+            if (tolower((unsigned char)*end) == 'i')
+                end++;
+            if (tolower((unsigned char)*end) == 'b')
+                end++;
+            break;
+        case 'b':
+            end++;
+            break;
+    }
+    return *end ? -1 : (int64_t)size;
+}
+
 #define ALIGN_PADDING    0x100000
 #define CACHE_LINE_SIZE  128
 
@@ -316,10 +911,11 @@ static char *align_up(char *ptr, int align)
     return (char *)(((uintptr_t)ptr + align - 1) & ~(uintptr_t)(align - 1));
 }
 
-void *alloc_four_nonaliased_buffers(void **buf1_, int size1,
-                                    void **buf2_, int size2,
-                                    void **buf3_, int size3,
-                                    void **buf4_, int size4)
+void *alloc_four_nonaliased_buffers(void **buf1_, int64_t size1,
+                                    void **buf2_, int64_t size2,
+                                    void **buf3_, int64_t size3,
+                                    void **buf4_, int64_t size4,
+                                    int page_mode)
 {
     char **buf1 = (char **)buf1_, **buf2 = (char **)buf2_;
     char **buf3 = (char **)buf3_, **buf4 = (char **)buf4_;
@@ -335,8 +931,10 @@ void *alloc_four_nonaliased_buffers(void **buf1_, int size1,
     if (!buf4 || size4 < 0)
         size4 = 0;
 
-    ptr = buf = 
-        (char *)malloc(size1 + size2 + size3 + size4 + 9 * ALIGN_PADDING);
+    ptr = buf = (char *)alloc_pages(size1 + size2 + size3 + size4 +
+                                    9 * ALIGN_PADDING, page_mode);
+    if (!buf)
+        return NULL;
     memset(buf, 0xCC, size1 + size2 + size3 + size4 + 9 * ALIGN_PADDING);
 
     ptr = align_up(ptr, ALIGN_PADDING);
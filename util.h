@@ -26,7 +26,6 @@
 
 #include <stdint.h>
 
-double gettime(void);
 double fmin(double, double);
 
 void aligned_block_copy(int64_t * __restrict dst,
@@ -50,6 +49,36 @@ void aligned_block_copy_pf64(int64_t * __restrict dst,
                              int64_t * __restrict src,
                              int                  size);
 
+void aligned_block_read(int64_t * __restrict dst,
+                        int64_t * __restrict src,
+                        int                  size);
+void aligned_block_read_pf32(int64_t * __restrict dst,
+                             int64_t * __restrict src,
+                             int                  size);
+void aligned_block_read_pf64(int64_t * __restrict dst,
+                             int64_t * __restrict src,
+                             int                  size);
+
+void aligned_block_read2(int64_t * __restrict dst,
+                         int64_t * __restrict src,
+                         int                  size);
+void aligned_block_read2_pf32(int64_t * __restrict dst,
+                              int64_t * __restrict src,
+                              int                  size);
+void aligned_block_read2_pf64(int64_t * __restrict dst,
+                              int64_t * __restrict src,
+                              int                  size);
+
+void aligned_block_read4(int64_t * __restrict dst,
+                         int64_t * __restrict src,
+                         int                  size);
+void aligned_block_read4_pf32(int64_t * __restrict dst,
+                              int64_t * __restrict src,
+                              int                  size);
+void aligned_block_read4_pf64(int64_t * __restrict dst,
+                              int64_t * __restrict src,
+                              int                  size);
+
 void aligned_block_fill(int64_t * __restrict dst,
                         int64_t * __restrict src,
                         int                  size);
@@ -63,9 +92,88 @@ void aligned_block_fill_shuffle64(int64_t * __restrict dst,
                                   int64_t * __restrict src,
                                   int                  size);
 
-void *alloc_four_nonaliased_buffers(void **buf1, int size1,
-                                    void **buf2, int size2,
-                                    void **buf3, int size3,
-                                    void **buf4, int size4);
+void aligned_block_rw31(int64_t * __restrict dst,
+                        int64_t * __restrict src,
+                        int                  size);
+void aligned_block_rw21(int64_t * __restrict dst,
+                        int64_t * __restrict src,
+                        int                  size);
+void aligned_block_rw11(int64_t * __restrict dst,
+                        int64_t * __restrict src,
+                        int                  size);
+void aligned_block_rw12(int64_t * __restrict dst,
+                        int64_t * __restrict src,
+                        int                  size);
+
+/*
+ * Set the prefetch distance (in bytes) for the *_pfdist kernels, the number
+ * at the end of their names is the locality hint of __builtin_prefetch().
+ */
+void set_prefetch_distance(int distance);
+
+void aligned_block_read_pfdist0(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size);
+void aligned_block_read_pfdist1(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size);
+void aligned_block_read_pfdist2(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size);
+void aligned_block_read_pfdist3(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size);
+void aligned_block_copy_pfdist0(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size);
+void aligned_block_copy_pfdist1(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size);
+void aligned_block_copy_pfdist2(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size);
+void aligned_block_copy_pfdist3(int64_t * __restrict dst,
+                                int64_t * __restrict src,
+                                int                  size);
+
+void stream_copy(double * __restrict dst,
+                 double * __restrict src1,
+                 double * __restrict src2,
+                 int                 size);
+void stream_scale(double * __restrict dst,
+                  double * __restrict src1,
+                  double * __restrict src2,
+                  int                 size);
+void stream_add(double * __restrict dst,
+                double * __restrict src1,
+                double * __restrict src2,
+                int                 size);
+void stream_triad(double * __restrict dst,
+                  double * __restrict src1,
+                  double * __restrict src2,
+                  int                 size);
+
+/*
+ * Match the string against a shell style wildcard pattern ('*' and '?'),
+ * ignoring the case.
+ */
+int glob_match(const char *pattern, const char *s);
+
+/*
+ * Parse a size with an optional K, M or G suffix (binary units, optionally
+ * followed by "iB" or "B"). Returns -1 on error.
+ */
+int64_t parse_size(const char *s);
+
+/*
+ * Allocate up to four buffers in a single memory pool backed by the pages
+ * of the given kind (see alloc.h), placed so that they don't alias each
+ * other in the caches. The returned pool must be released by free_pages().
+ */
+void *alloc_four_nonaliased_buffers(void **buf1, int64_t size1,
+                                    void **buf2, int64_t size2,
+                                    void **buf3, int64_t size3,
+                                    void **buf4, int64_t size4,
+                                    int page_mode);
 
 #endif
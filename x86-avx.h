@@ -0,0 +1,152 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __X86_AVX_H__
+#define __X86_AVX_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void aligned_block_copy_avx(int64_t * __restrict dst,
+                            int64_t * __restrict src,
+                            int                  size);
+void unaligned_block_copy_avx(int64_t * __restrict dst,
+                              int64_t * __restrict src,
+                              int                  size);
+void aligned_block_copy_nt_avx(int64_t * __restrict dst,
+                               int64_t * __restrict src,
+                               int                  size);
+void aligned_block_copy_pf32_avx(int64_t * __restrict dst,
+                                 int64_t * __restrict src,
+                                 int                  size);
+void aligned_block_copy_pf64_avx(int64_t * __restrict dst,
+                                 int64_t * __restrict src,
+                                 int                  size);
+void aligned_block_copy_nt_pf32_avx(int64_t * __restrict dst,
+                                    int64_t * __restrict src,
+                                    int                  size);
+void aligned_block_copy_nt_pf64_avx(int64_t * __restrict dst,
+                                    int64_t * __restrict src,
+                                    int                  size);
+void aligned_block_rw31_avx(int64_t * __restrict dst,
+                            int64_t * __restrict src,
+                            int                  size);
+void aligned_block_rw21_avx(int64_t * __restrict dst,
+                            int64_t * __restrict src,
+                            int                  size);
+void aligned_block_rw11_avx(int64_t * __restrict dst,
+                            int64_t * __restrict src,
+                            int                  size);
+void aligned_block_rw12_avx(int64_t * __restrict dst,
+                            int64_t * __restrict src,
+                            int                  size);
+
+void aligned_block_fill_avx(int64_t * __restrict dst,
+                            int64_t * __restrict src,
+                            int                  size);
+void aligned_block_fill_nt_avx(int64_t * __restrict dst,
+                               int64_t * __restrict src,
+                               int                  size);
+void aligned_block_read_avx(int64_t * __restrict dst,
+                            int64_t * __restrict src,
+                            int                  size);
+void aligned_block_read_pf64_avx(int64_t * __restrict dst,
+                                 int64_t * __restrict src,
+                                 int                  size);
+void aligned_block_read2_avx(int64_t * __restrict dst,
+                             int64_t * __restrict src,
+                             int                  size);
+void aligned_block_read4_avx(int64_t * __restrict dst,
+                             int64_t * __restrict src,
+                             int                  size);
+
+void aligned_block_copy_ntload_avx2(int64_t * __restrict dst,
+                                    int64_t * __restrict src,
+                                    int                  size);
+void aligned_block_copy_ntload_nt_avx2(int64_t * __restrict dst,
+                                       int64_t * __restrict src,
+                                       int                  size);
+
+void aligned_block_copy_avx512(int64_t * __restrict dst,
+                               int64_t * __restrict src,
+                               int                  size);
+void aligned_block_copy_nt_avx512(int64_t * __restrict dst,
+                                  int64_t * __restrict src,
+                                  int                  size);
+void aligned_block_copy_pf64_avx512(int64_t * __restrict dst,
+                                    int64_t * __restrict src,
+                                    int                  size);
+void aligned_block_copy_nt_pf64_avx512(int64_t * __restrict dst,
+                                       int64_t * __restrict src,
+                                       int                  size);
+void aligned_block_fill_avx512(int64_t * __restrict dst,
+                               int64_t * __restrict src,
+                               int                  size);
+void aligned_block_fill_nt_avx512(int64_t * __restrict dst,
+                                  int64_t * __restrict src,
+                                  int                  size);
+void aligned_block_read_avx512(int64_t * __restrict dst,
+                               int64_t * __restrict src,
+                               int                  size);
+
+void stream_copy_avx(double * __restrict dst,
+                     double * __restrict src1,
+                     double * __restrict src2,
+                     int                 size);
+void stream_scale_avx(double * __restrict dst,
+                      double * __restrict src1,
+                      double * __restrict src2,
+                      int                 size);
+void stream_add_avx(double * __restrict dst,
+                    double * __restrict src1,
+                    double * __restrict src2,
+                    int                 size);
+void stream_triad_avx(double * __restrict dst,
+                      double * __restrict src1,
+                      double * __restrict src2,
+                      int                 size);
+void stream_copy_nt_avx(double * __restrict dst,
+                        double * __restrict src1,
+                        double * __restrict src2,
+                        int                 size);
+void stream_scale_nt_avx(double * __restrict dst,
+                         double * __restrict src1,
+                         double * __restrict src2,
+                         int                 size);
+void stream_add_nt_avx(double * __restrict dst,
+                       double * __restrict src1,
+                       double * __restrict src2,
+                       int                 size);
+void stream_triad_nt_avx(double * __restrict dst,
+                         double * __restrict src1,
+                         double * __restrict src2,
+                         int                 size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -40,6 +40,9 @@ void aligned_block_copy_movsd(int64_t * __restrict dst,
 void aligned_block_copy_sse2(int64_t * __restrict dst,
                              int64_t * __restrict src,
                              int                  size);
+void unaligned_block_copy_sse2(int64_t * __restrict dst,
+                               int64_t * __restrict src,
+                               int                  size);
 void aligned_block_copy_nt_sse2(int64_t * __restrict dst,
                                 int64_t * __restrict src,
                                 int                  size);
@@ -58,6 +61,43 @@ void aligned_block_copy_nt_pf64_sse2(int64_t * __restrict dst,
                                      int64_t * __restrict src,
                                      int                  size);
 
+void aligned_block_read_sse2(int64_t * __restrict dst,
+                             int64_t * __restrict src,
+                             int                  size);
+void aligned_block_read_pf32_sse2(int64_t * __restrict dst,
+                                  int64_t * __restrict src,
+                                  int                  size);
+void aligned_block_read_pf64_sse2(int64_t * __restrict dst,
+                                  int64_t * __restrict src,
+                                  int                  size);
+
+void aligned_block_read2_sse2(int64_t * __restrict dst,
+                              int64_t * __restrict src,
+                              int                  size);
+void aligned_block_read2_pf64_sse2(int64_t * __restrict dst,
+                                   int64_t * __restrict src,
+                                   int                  size);
+
+void aligned_block_read4_sse2(int64_t * __restrict dst,
+                              int64_t * __restrict src,
+                              int                  size);
+void aligned_block_read4_pf64_sse2(int64_t * __restrict dst,
+                                   int64_t * __restrict src,
+                                   int                  size);
+
+void aligned_block_rw31_sse2(int64_t * __restrict dst,
+                             int64_t * __restrict src,
+                             int                  size);
+void aligned_block_rw21_sse2(int64_t * __restrict dst,
+                             int64_t * __restrict src,
+                             int                  size);
+void aligned_block_rw11_sse2(int64_t * __restrict dst,
+                             int64_t * __restrict src,
+                             int                  size);
+void aligned_block_rw12_sse2(int64_t * __restrict dst,
+                             int64_t * __restrict src,
+                             int                  size);
+
 void aligned_block_fill_sse2(int64_t * __restrict dst,
                              int64_t * __restrict src,
                              int                  size);
@@ -66,6 +106,39 @@ void aligned_block_fill_nt_sse2(int64_t * __restrict dst,
                                 int64_t * __restrict src,
                                 int                  size);
 
+void stream_copy_sse2(double * __restrict dst,
+                      double * __restrict src1,
+                      double * __restrict src2,
+                      int                 size);
+void stream_scale_sse2(double * __restrict dst,
+                       double * __restrict src1,
+                       double * __restrict src2,
+                       int                 size);
+void stream_add_sse2(double * __restrict dst,
+                     double * __restrict src1,
+                     double * __restrict src2,
+                     int                 size);
+void stream_triad_sse2(double * __restrict dst,
+                       double * __restrict src1,
+                       double * __restrict src2,
+                       int                 size);
+void stream_copy_nt_sse2(double * __restrict dst,
+                         double * __restrict src1,
+                         double * __restrict src2,
+                         int                 size);
+void stream_scale_nt_sse2(double * __restrict dst,
+                          double * __restrict src1,
+                          double * __restrict src2,
+                          int                 size);
+void stream_add_nt_sse2(double * __restrict dst,
+                        double * __restrict src1,
+                        double * __restrict src2,
+                        int                 size);
+void stream_triad_nt_sse2(double * __restrict dst,
+                          double * __restrict src1,
+                          double * __restrict src2,
+                          int                 size);
+
 #ifdef __cplusplus
 }
 #endif